@@ -31,6 +31,9 @@ static void print_check_usage(bool is_subcommand) {
 	printf(IDENT2 "common options:\n");
 
 	printf(IDENT3 "-l, --loglevel <loglevel>: Set the log level for the application\n");
+	printf(IDENT3 "-j, --threads <amount>: Set the maximum amount of threads used for parsing\n");
+	printf(IDENT3 "-e, --max-errors <amount>: Skip over broken lines and sections and report up "
+	              "to that many errors, 0 means no limit\n");
 
 	printf(IDENT2 "common strictness options\n");
 
@@ -269,6 +272,51 @@ static void print_usage(const char* program_name, UsageCommand usage_command) {
 
 			log_level = parsed_level;
 
+			processed_args += 2;
+		} else if((strcmp(arg, "-j") == 0) || (strcmp(arg, "--threads") == 0)) {
+			if(processed_args + 2 > argc) {
+				fprintf(stderr, "Not enough arguments for the 'threads' option\n");
+				print_usage(argv[0], UsageCommandCheck);
+				return EXIT_FAILURE;
+			}
+
+			const char* thread_count_str = argv[processed_args + 1];
+
+			char* end_ptr = NULL;
+			unsigned long thread_count = strtoul(thread_count_str, &end_ptr, 10);
+
+			if(*thread_count_str == '\0' || *end_ptr != '\0') {
+				fprintf(stderr, "Wrong option for the 'threads' option, not a number: %s\n",
+				        thread_count_str);
+				print_usage(argv[0], UsageCommandCheck);
+				return EXIT_FAILURE;
+			}
+
+			settings.thread_count = (size_t)thread_count;
+
+			processed_args += 2;
+		} else if((strcmp(arg, "-e") == 0) || (strcmp(arg, "--max-errors") == 0)) {
+			if(processed_args + 2 > argc) {
+				fprintf(stderr, "Not enough arguments for the 'max-errors' option\n");
+				print_usage(argv[0], UsageCommandCheck);
+				return EXIT_FAILURE;
+			}
+
+			const char* max_errors_str = argv[processed_args + 1];
+
+			char* end_ptr = NULL;
+			unsigned long max_errors = strtoul(max_errors_str, &end_ptr, 10);
+
+			if(*max_errors_str == '\0' || *end_ptr != '\0') {
+				fprintf(stderr, "Wrong option for the 'max-errors' option, not a number: %s\n",
+				        max_errors_str);
+				print_usage(argv[0], UsageCommandCheck);
+				return EXIT_FAILURE;
+			}
+
+			settings.recover_from_errors = true;
+			settings.max_recovered_errors = (size_t)max_errors;
+
 			processed_args += 2;
 		} else {
 			fprintf(stderr, "Unrecognized option: %s\n", arg);
@@ -306,12 +354,34 @@ static void print_usage(const char* program_name, UsageCommand usage_command) {
 		}
 	}
 
+	RecoveredErrors recovered_errors = get_recovered_errors_from_result(result);
+
+	{
+		// log recovered errors
+
+		for(size_t i = 0; i < stbds_arrlenu(recovered_errors.entries); ++i) {
+			RecoveredError entry = recovered_errors.entries[i];
+
+			char* location = get_normalized_string(entry.location);
+
+			LOG_MESSAGE(LogLevelError, "Parse error in '%s' section at '%s': %s\n", entry.section,
+			            location ? location : "<allocation error>", entry.error.message);
+
+			free(location);
+		}
+	}
+
 	if(parse_result_is_error(result)) {
 		LOG_MESSAGE(LogLevelError, "Parse error: %s\n", parse_result_get_error(result));
 		free_parse_result(result);
 		return EXIT_FAILURE;
 	}
 
+	if(stbds_arrlenu(recovered_errors.entries) != 0) {
+		free_parse_result(result);
+		return EXIT_FAILURE;
+	}
+
 	LOG_MESSAGE_SIMPLE(LogLevelInfo, "File is valid\n");
 	free_parse_result(result);
 	return EXIT_SUCCESS;
@@ -0,0 +1,495 @@
+#include "./arena.h"
+
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+[[nodiscard]] void* allocator_malloc(const AssAllocator* allocator, size_t size) {
+
+	if(allocator == NULL) {
+		return malloc(size);
+	}
+
+	return allocator->malloc_fn(allocator->user_data, size);
+}
+
+[[nodiscard]] void* allocator_realloc(const AssAllocator* allocator, void* ptr, size_t size) {
+
+	if(allocator == NULL) {
+		return realloc(ptr, size);
+	}
+
+	return allocator->realloc_fn(allocator->user_data, ptr, size);
+}
+
+void allocator_free(const AssAllocator* allocator, void* ptr) {
+
+	if(allocator == NULL) {
+		free(ptr);
+		return;
+	}
+
+	allocator->free_fn(allocator->user_data, ptr);
+}
+
+#define ALLOCATION_ALIGNMENT (alignof(max_align_t))
+
+#define ALIGN_SIZE(size) \
+	(((size) + (ALLOCATION_ALIGNMENT - 1)) & ~((size_t)ALLOCATION_ALIGNMENT - 1))
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+// allocations of at least this size get a block of their own
+#define ARENA_DEDICATED_SIZE (8 * 1024)
+
+struct ArenaBlock {
+	Arena* arena;
+	ArenaBlock* previous;
+	ArenaBlock* next;
+	size_t size;
+	size_t used;
+	bool is_dedicated;
+};
+
+// stored in front of every allocation, so that it can be resized and freed without knowing, where
+// it came from
+struct AllocationHeader {
+	// NULL, if the memory comes directly from the allocator
+	ArenaBlock* block;
+	union {
+		// only used, if the memory is not in an arena
+		const AssAllocator* allocator;
+		// only used, while the memory is in a free list of its arena
+		AllocationHeader* next_free;
+	};
+	size_t size;
+	// the usable size in the arena, a reused allocation may be bigger than its size
+	size_t capacity;
+};
+
+#define BLOCK_HEADER_SIZE ALIGN_SIZE(sizeof(ArenaBlock))
+
+#define ALLOCATION_HEADER_SIZE ALIGN_SIZE(sizeof(AllocationHeader))
+
+// the free list i has the allocations with a capacity in [2^(i + 4), 2^(i + 5)), smaller ones are
+// not reused
+#define MIN_REUSED_CAPACITY 16
+
+// only the start of a free list is searched for a fitting allocation, so that a long list doesn't
+// slow down every allocation
+#define FREE_LIST_SEARCH_LENGTH 8
+
+static _Thread_local ThreadAllocation s_thread_allocation = { .allocator = NULL, .arena = NULL };
+
+// only held for a few pointer changes, never while the allocator of the user runs
+static void lock_block_list(Arena* arena) {
+	pthread_mutex_lock(&(arena->block_list_mutex));
+}
+
+static void unlock_block_list(Arena* arena) {
+	pthread_mutex_unlock(&(arena->block_list_mutex));
+}
+
+[[nodiscard]] static char* get_block_data(ArenaBlock* block) {
+	return (char*)block + BLOCK_HEADER_SIZE;
+}
+
+[[nodiscard]] static AllocationHeader* get_allocation_header(void* ptr) {
+	return (AllocationHeader*)((char*)ptr - ALLOCATION_HEADER_SIZE);
+}
+
+[[nodiscard]] static void* get_allocation_data(AllocationHeader* header) {
+	return (char*)header + ALLOCATION_HEADER_SIZE;
+}
+
+// has to be called with the block list of the arena locked
+static void link_block(Arena* arena, ArenaBlock* block) {
+	block->arena = arena;
+	block->previous = NULL;
+	block->next = arena->blocks;
+
+	if(arena->blocks != NULL) {
+		arena->blocks->previous = block;
+	}
+
+	arena->blocks = block;
+}
+
+// has to be called with the block list of the arena of the block locked
+static void unlink_block(ArenaBlock* block) {
+	if(block->previous != NULL) {
+		block->previous->next = block->next;
+	} else {
+		block->arena->blocks = block->next;
+	}
+
+	if(block->next != NULL) {
+		block->next->previous = block->previous;
+	}
+}
+
+[[nodiscard]] static ArenaBlock* alloc_block(Arena* arena, size_t size, bool is_dedicated) {
+
+	ArenaBlock* block = (ArenaBlock*)allocator_malloc(arena->allocator, BLOCK_HEADER_SIZE + size);
+
+	if(!block) {
+		return NULL;
+	}
+
+	block->size = size;
+	block->used = 0;
+	block->is_dedicated = is_dedicated;
+
+	lock_block_list(arena);
+	link_block(arena, block);
+	unlock_block_list(arena);
+
+	return block;
+}
+
+[[nodiscard]] static size_t get_free_list_index(size_t capacity) {
+
+	size_t index = 0;
+
+	while(index < ARENA_FREE_LIST_COUNT - 1 &&
+	      capacity >= ((size_t)MIN_REUSED_CAPACITY << (index + 1))) {
+		++index;
+	}
+
+	return index;
+}
+
+static void push_free_allocation(Arena* arena, AllocationHeader* header) {
+
+	size_t index = get_free_list_index(header->capacity);
+
+	header->next_free = arena->free_lists[index];
+	arena->free_lists[index] = header;
+}
+
+// takes the first allocation of the matching free list, that is big enough, or the first one of
+// the next non empty list, every allocation there is big enough, an allocation, that grew in place
+// before it was freed, is found that way by the smaller allocation, that it started as
+[[nodiscard]] static AllocationHeader* pop_free_allocation(Arena* arena, size_t capacity) {
+
+	size_t index = get_free_list_index(capacity);
+
+	AllocationHeader** previous_next = &(arena->free_lists[index]);
+
+	for(size_t i = 0; i < FREE_LIST_SEARCH_LENGTH && *previous_next != NULL; ++i) {
+		AllocationHeader* header = *previous_next;
+
+		if(header->capacity >= capacity) {
+			*previous_next = header->next_free;
+			return header;
+		}
+
+		previous_next = &(header->next_free);
+	}
+
+	for(size_t i = index + 1; i < ARENA_FREE_LIST_COUNT; ++i) {
+		AllocationHeader* header = arena->free_lists[i];
+
+		if(header != NULL) {
+			arena->free_lists[i] = header->next_free;
+			return header;
+		}
+	}
+
+	return NULL;
+}
+
+[[nodiscard]] static void* alloc_in_arena(Arena* arena, size_t size) {
+
+	size_t capacity = ALIGN_SIZE(size);
+	size_t needed_size = ALLOCATION_HEADER_SIZE + capacity;
+
+	// the free lists are only used by the thread, that allocates in the arena
+	if(size < ARENA_DEDICATED_SIZE && capacity >= MIN_REUSED_CAPACITY &&
+	   arena == s_thread_allocation.arena) {
+		AllocationHeader* header = pop_free_allocation(arena, capacity);
+
+		if(header != NULL) {
+			header->allocator = NULL;
+			header->size = size;
+			return get_allocation_data(header);
+		}
+	}
+
+	ArenaBlock* block = NULL;
+
+	if(size >= ARENA_DEDICATED_SIZE) {
+		block = alloc_block(arena, needed_size, true);
+	} else {
+		block = arena->current;
+
+		// the rest of the current block is wasted
+		if(block == NULL || block->size - block->used < needed_size) {
+			block = alloc_block(arena, ARENA_BLOCK_SIZE, false);
+			arena->current = block;
+		}
+	}
+
+	if(!block) {
+		return NULL;
+	}
+
+	AllocationHeader* header = (AllocationHeader*)(get_block_data(block) + block->used);
+	header->block = block;
+	header->allocator = NULL;
+	header->size = size;
+	header->capacity = capacity;
+
+	block->used += needed_size;
+
+	return get_allocation_data(header);
+}
+
+// only the arena of the current thread can be changed, as other threads may allocate in theirs
+[[nodiscard]] static bool is_last_allocation(AllocationHeader* header) {
+
+	ArenaBlock* block = header->block;
+
+	if(block->arena != s_thread_allocation.arena || block != block->arena->current) {
+		return false;
+	}
+
+	return (char*)header + ALLOCATION_HEADER_SIZE + header->capacity ==
+	       get_block_data(block) + block->used;
+}
+
+[[nodiscard]] void* ass_malloc(size_t size) {
+
+	const AssAllocator* allocator = s_thread_allocation.allocator;
+
+	AllocationHeader* header =
+	    (AllocationHeader*)allocator_malloc(allocator, ALLOCATION_HEADER_SIZE + size);
+
+	if(!header) {
+		return NULL;
+	}
+
+	header->block = NULL;
+	header->allocator = allocator;
+	header->size = size;
+	header->capacity = size;
+
+	return get_allocation_data(header);
+}
+
+[[nodiscard]] void* ass_arena_malloc(size_t size) {
+
+	if(s_thread_allocation.arena != NULL) {
+		return alloc_in_arena(s_thread_allocation.arena, size);
+	}
+
+	return ass_malloc(size);
+}
+
+[[nodiscard]] static void* realloc_dedicated_block(AllocationHeader* header, size_t size) {
+
+	ArenaBlock* block = header->block;
+	Arena* arena = block->arena;
+	size_t needed_size = ALLOCATION_HEADER_SIZE + ALIGN_SIZE(size);
+
+	// the block may move, so it is taken out of the list, while the allocator of the user runs
+	lock_block_list(arena);
+	unlink_block(block);
+	unlock_block_list(arena);
+
+	ArenaBlock* new_block =
+	    (ArenaBlock*)allocator_realloc(arena->allocator, block, BLOCK_HEADER_SIZE + needed_size);
+
+	// the old block is still valid, if the reallocation failed
+	lock_block_list(arena);
+	link_block(arena, new_block != NULL ? new_block : block);
+	unlock_block_list(arena);
+
+	if(!new_block) {
+		return NULL;
+	}
+
+	new_block->size = needed_size;
+	new_block->used = needed_size;
+
+	AllocationHeader* new_header = (AllocationHeader*)get_block_data(new_block);
+	new_header->block = new_block;
+	new_header->size = size;
+	new_header->capacity = ALIGN_SIZE(size);
+
+	return get_allocation_data(new_header);
+}
+
+[[nodiscard]] void* ass_realloc(void* ptr, size_t size) {
+
+	if(ptr == NULL) {
+		return ass_malloc(size);
+	}
+
+	AllocationHeader* header = get_allocation_header(ptr);
+
+	if(header->block == NULL) {
+		AllocationHeader* new_header = (AllocationHeader*)allocator_realloc(
+		    header->allocator, header, ALLOCATION_HEADER_SIZE + size);
+
+		if(!new_header) {
+			return NULL;
+		}
+
+		new_header->size = size;
+		new_header->capacity = size;
+
+		return get_allocation_data(new_header);
+	}
+
+	if(header->block->is_dedicated) {
+		return realloc_dedicated_block(header, size);
+	}
+
+	if(size <= header->capacity) {
+		header->size = size;
+		return ptr;
+	}
+
+	ArenaBlock* block = header->block;
+
+	if(size < ARENA_DEDICATED_SIZE && is_last_allocation(header) &&
+	   block->size - block->used >= ALIGN_SIZE(size) - header->capacity) {
+		block->used += ALIGN_SIZE(size) - header->capacity;
+		header->size = size;
+		header->capacity = ALIGN_SIZE(size);
+		return ptr;
+	}
+
+	Arena* arena = s_thread_allocation.arena != NULL ? s_thread_allocation.arena : block->arena;
+
+	void* new_ptr = alloc_in_arena(arena, size);
+
+	if(!new_ptr) {
+		return NULL;
+	}
+
+	memcpy(new_ptr, ptr, header->size);
+
+	ass_free(ptr);
+
+	return new_ptr;
+}
+
+[[nodiscard]] void* ass_arena_realloc(void* ptr, size_t size) {
+
+	if(ptr == NULL) {
+		return ass_arena_malloc(size);
+	}
+
+	return ass_realloc(ptr, size);
+}
+
+void ass_free(void* ptr) {
+
+	if(ptr == NULL) {
+		return;
+	}
+
+	AllocationHeader* header = get_allocation_header(ptr);
+	ArenaBlock* block = header->block;
+
+	if(block == NULL) {
+		allocator_free(header->allocator, header);
+		return;
+	}
+
+	if(block->is_dedicated) {
+		Arena* arena = block->arena;
+
+		lock_block_list(arena);
+		unlink_block(block);
+		unlock_block_list(arena);
+
+		allocator_free(arena->allocator, block);
+		return;
+	}
+
+	if(is_last_allocation(header)) {
+		block->used = (size_t)((char*)header - get_block_data(block));
+		return;
+	}
+
+	// the memory is reused by later allocations of the thread, that allocates in the arena,
+	// everything else is freed together with the arena
+	if(block->arena == s_thread_allocation.arena && header->capacity >= MIN_REUSED_CAPACITY) {
+		push_free_allocation(block->arena, header);
+	}
+}
+
+[[nodiscard]] bool init_arena(Arena* arena, const AssAllocator* allocator) {
+
+	arena->allocator = allocator;
+	arena->blocks = NULL;
+	arena->current = NULL;
+
+	for(size_t i = 0; i < ARENA_FREE_LIST_COUNT; ++i) {
+		arena->free_lists[i] = NULL;
+	}
+
+	return pthread_mutex_init(&(arena->block_list_mutex), NULL) == 0;
+}
+
+void free_arena(Arena* arena) {
+
+	ArenaBlock* block = arena->blocks;
+
+	while(block != NULL) {
+		ArenaBlock* next = block->next;
+		allocator_free(arena->allocator, block);
+		block = next;
+	}
+
+	arena->blocks = NULL;
+	arena->current = NULL;
+
+	pthread_mutex_destroy(&(arena->block_list_mutex));
+}
+
+// several threads may merge into the same destination at the same time, so both lists are locked,
+// the source first, as it is never the destination of another merge at the same time
+void merge_arena(Arena* destination, Arena* source) {
+
+	lock_block_list(source);
+	lock_block_list(destination);
+
+	ArenaBlock* block = source->blocks;
+
+	while(block != NULL) {
+		ArenaBlock* next = block->next;
+		link_block(destination, block);
+		block = next;
+	}
+
+	unlock_block_list(destination);
+
+	source->blocks = NULL;
+	source->current = NULL;
+
+	// the free allocations of the source are only reused, once the arena is freed
+	for(size_t i = 0; i < ARENA_FREE_LIST_COUNT; ++i) {
+		source->free_lists[i] = NULL;
+	}
+
+	unlock_block_list(source);
+}
+
+ThreadAllocation set_thread_allocation(ThreadAllocation allocation) {
+
+	ThreadAllocation previous = s_thread_allocation;
+
+	s_thread_allocation = allocation;
+
+	return previous;
+}
+
+[[nodiscard]] ThreadAllocation get_thread_allocation(void) {
+	return s_thread_allocation;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stddef.h>
+
+// allocation functions of the user, all of them get the user data as first argument
+typedef struct {
+	void* (*malloc_fn)(void* user_data, size_t size);
+	void* (*realloc_fn)(void* user_data, void* ptr, size_t size);
+	void (*free_fn)(void* user_data, void* ptr);
+	void* user_data;
+} AssAllocator;
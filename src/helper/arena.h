@@ -0,0 +1,78 @@
+#pragma once
+
+#include "./allocator.h"
+
+#include <pthread.h>
+#include <stddef.h>
+
+// the allocation functions of the library, this header is not installed, only AssAllocator is
+// part of the public api
+
+// a NULL allocator means malloc, realloc and free
+[[nodiscard]] void* allocator_malloc(const AssAllocator* allocator, size_t size);
+
+[[nodiscard]] void* allocator_realloc(const AssAllocator* allocator, void* ptr, size_t size);
+
+void allocator_free(const AssAllocator* allocator, void* ptr);
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct AllocationHeader AllocationHeader;
+
+#define ARENA_FREE_LIST_COUNT 10
+
+// small allocations are placed one after another in big blocks, big allocations get a block of
+// their own, so that they can still be resized and freed, freeing the arena frees every block
+typedef struct {
+	// the blocks are allocated with this allocator
+	const AssAllocator* allocator;
+	ArenaBlock* blocks;
+	// the block, in which the next small allocation is placed
+	ArenaBlock* current;
+	// freed small allocations by size, they are reused before new memory is taken from a block
+	AllocationHeader* free_lists[ARENA_FREE_LIST_COUNT];
+	// only guards the list of blocks, as a block may be freed by another thread, than the one, that
+	// allocated it, and other arenas may be merged into this one at the same time
+	pthread_mutex_t block_list_mutex;
+} Arena;
+
+// the arena is initialized in place and must not be copied afterwards, as it contains a mutex,
+// returns false, if the mutex couldn't be created
+[[nodiscard]] bool init_arena(Arena* arena, const AssAllocator* allocator);
+
+// frees every block and the mutex, the arena has to be initialized again, before it is used again
+void free_arena(Arena* arena);
+
+// moves all blocks of the source into the destination, the source is empty afterwards
+void merge_arena(Arena* destination, Arena* source);
+
+// where the new allocations of a thread go to, a NULL arena means directly to the allocator
+typedef struct {
+	const AssAllocator* allocator;
+	Arena* arena;
+} ThreadAllocation;
+
+// returns the allocation, that was set before
+ThreadAllocation set_thread_allocation(ThreadAllocation allocation);
+
+[[nodiscard]] ThreadAllocation get_thread_allocation(void);
+
+// everything, that the parser allocates, goes through these functions, the memory remembers where
+// it came from, so reallocations and frees always go back there, regardless of the thread
+// allocation at that time
+
+// allocates with the allocator of the current thread, never in the arena
+[[nodiscard]] void* ass_malloc(size_t size);
+
+// allocates in the arena of the current thread, if there is one, this is used for everything, that
+// a parse result owns
+[[nodiscard]] void* ass_arena_malloc(size_t size);
+
+[[nodiscard]] void* ass_realloc(void* ptr, size_t size);
+
+// like ass_realloc, but a NULL ptr is allocated with ass_arena_malloc
+[[nodiscard]] void* ass_arena_realloc(void* ptr, size_t size);
+
+// freed small arena allocations are reused by later allocations of the thread, that allocates in
+// that arena, otherwise they are only freed together with the arena
+void ass_free(void* ptr);
@@ -1,6 +1,7 @@
 
 
 #include "./io.h"
+#include "./arena.h"
 
 // NOLINTBEGIN(readability-identifier-naming,bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
 #define _POSIX_C_SOURCE 200809L
@@ -33,7 +34,9 @@
 	return S_ISDIR(stat_struct.st_mode);
 }
 
-[[nodiscard]] static SizedPtr read_entire_file_raw(FILE* file) {
+// without a buffer, the data is allocated with the allocator of the current thread
+[[nodiscard]] static SizedPtr read_entire_file_raw(FILE* file, SizedPtr* buffer,
+                                                   const AssAllocator* allocator) {
 
 	if(file == NULL) {
 		if(errno == EACCES) {
@@ -63,21 +66,47 @@
 		return ptr_error("rewind error");
 	}
 
-	void* data = malloc(fsize);
+	// an empty allocation would look like an error
+	if(fsize == 0) {
+		fclose(file);
+		return (SizedPtr){ .data = NULL, .len = 0 };
+	}
+
+	void* data = NULL;
+
+	if(buffer == NULL) {
+		data = allocator_malloc(allocator, fsize);
+	} else {
+		if(buffer->len < (size_t)fsize) {
+			void* new_buffer = allocator_realloc(allocator, buffer->data, fsize);
+
+			if(new_buffer != NULL) {
+				buffer->data = new_buffer;
+				buffer->len = (size_t)fsize;
+			}
+		}
+
+		data = buffer->len < (size_t)fsize ? NULL : buffer->data;
+	}
+
 	if(data == NULL) {
 		return ptr_error("allocation error");
 	}
 	size_t actual_read = fread(data, 1, fsize, file);
 
 	if((size_t)fsize != actual_read) {
-		free(data);
+		if(buffer == NULL) {
+			allocator_free(allocator, data);
+		}
 		return ptr_error("read error");
 	}
 
 	res = fclose(file);
 
 	if(res != 0) {
-		free(data);
+		if(buffer == NULL) {
+			allocator_free(allocator, data);
+		}
 		return ptr_error("fclose error");
 	}
 
@@ -88,14 +117,26 @@
 
 	FILE* file = fopen(file_name, "rb");
 
-	return read_entire_file_raw(file);
+	// freed with free_sized_ptr
+	return read_entire_file_raw(file, NULL, get_thread_allocation().allocator);
+}
+
+[[nodiscard]] SizedPtr read_entire_file_into_buffer(const char* file_name, SizedPtr* buffer,
+                                                    const AssAllocator* allocator) {
+
+	FILE* file = fopen(file_name, "rb");
+
+	return read_entire_file_raw(file, buffer, allocator);
 }
 
 #define CHUNK_SIZE 512
 
 [[nodiscard]] static SizedPtr read_string_raw(int fd) {
 
-	char* start_buffer = (char*)malloc(CHUNK_SIZE);
+	// freed with free_sized_ptr
+	const AssAllocator* allocator = get_thread_allocation().allocator;
+
+	char* start_buffer = (char*)allocator_malloc(allocator, CHUNK_SIZE);
 
 	if(!start_buffer) {
 		return ptr_error("allocation error");
@@ -119,7 +160,8 @@
 
 		if(read_bytes == CHUNK_SIZE) {
 
-			char* new_buffer = (char*)realloc(result.data, result.len + CHUNK_SIZE);
+			char* new_buffer =
+			    (char*)allocator_realloc(allocator, result.data, result.len + CHUNK_SIZE);
 
 			if(!new_buffer) {
 				return ptr_error("realloc error");
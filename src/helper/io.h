@@ -2,8 +2,14 @@
 
 #pragma once
 
+#include "./allocator.h"
 #include "./sized_ptr.h"
 
 [[nodiscard]] SizedPtr read_entire_file(const char* file_name);
 
+// the buffer is reused between calls (its len is the capacity) and only grown with the allocator,
+// if the file doesn't fit, the result points into the buffer and must not be freed
+[[nodiscard]] SizedPtr read_entire_file_into_buffer(const char* file_name, SizedPtr* buffer,
+                                                    const AssAllocator* allocator);
+
 [[nodiscard]] SizedPtr read_entire_stdin(void);
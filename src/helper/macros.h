@@ -1,5 +1,7 @@
 #pragma once
 
+#include "./arena.h"
+
 #define UNUSED(v) ((void)(v))
 
 // cool trick from here:
@@ -19,10 +21,10 @@
 	{ \
 		char* internal_buffer = *to_store; \
 		if(internal_buffer != NULL) { \
-			free(internal_buffer); \
+			ass_free(internal_buffer); \
 		} \
 		int to_write = snprintf(NULL, 0, format, __VA_ARGS__) + 1; \
-		internal_buffer = (char*)malloc(to_write * sizeof(char)); \
+		internal_buffer = (char*)ass_malloc(to_write * sizeof(char)); \
 		if(!internal_buffer) { \
 			fprintf(stderr, "Couldn't allocate memory for %d bytes!\n", to_write); \
 			error_statement; \
@@ -33,7 +35,7 @@
 			        "Snprint did write more bytes then it had space in the buffer, available " \
 			        "space:'%d', actually written:'%d'!\n", \
 			        (to_write) - 1, written); \
-			free(internal_buffer); \
+			ass_free(internal_buffer); \
 			error_statement; \
 		} \
 		*to_store = internal_buffer; \
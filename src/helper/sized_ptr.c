@@ -1,7 +1,6 @@
 
 #include "./sized_ptr.h"
-
-#include <stdlib.h>
+#include "./arena.h"
 
 [[nodiscard]] bool is_ptr_error(SizedPtr ptr) {
 	return ptr.len == 0 && ptr.data != NULL;
@@ -16,5 +15,5 @@
 }
 
 void free_sized_ptr(SizedPtr ptr) {
-	free(ptr.data);
+	allocator_free(get_thread_allocation().allocator, ptr.data);
 }
@@ -14,4 +14,6 @@ typedef struct {
 
 [[nodiscard]] const char* ptr_get_error(SizedPtr ptr);
 
+// the data is allocated directly with the allocator of the current thread (see arena.h), so
+// that data of the user can be passed in too
 void free_sized_ptr(SizedPtr ptr);
@@ -185,36 +185,40 @@ typedef bool (*DelimiterFn)(int32_t code_point, void* data_ptr);
 	return true;
 }
 
-[[nodiscard]] static bool str_view_skip_while(StrView* str_view, DelimiterFn delimit_fn,
-                                              void* data_ptr) {
+[[nodiscard]] bool category_delimiter(int32_t code_point, void* data_ptr) {
 
-	while(true) {
-		if(str_view_is_eof(*str_view)) {
-			return true;
-		}
+	return utf8proc_category(code_point) == (*(utf8proc_category_t*)data_ptr);
+}
 
-		int32_t current_codepoint = str_view->start[str_view->offset];
+#define ASCII_TABLE_SIZE 0x80
 
-		if(!delimit_fn(current_codepoint, data_ptr)) {
-			return true;
-		}
+// in the ascii range only ' ' is in the Zs (space separator) category, so a lookup table is enough
+// there and utf8proc only needs to be asked for the remaining codepoints
+static const bool g_ascii_space_separator_table[ASCII_TABLE_SIZE] = { [' '] = true };
 
-		str_view->offset++;
+[[nodiscard]] static inline bool is_space_separator(int32_t code_point) {
+
+	if(code_point >= 0 && code_point < ASCII_TABLE_SIZE) {
+		return g_ascii_space_separator_table[code_point];
 	}
 
-	return true;
+	return utf8proc_category(code_point) == UTF8PROC_CATEGORY_ZS;
 }
 
-[[nodiscard]] bool category_delimiter(int32_t code_point, void* data_ptr) {
+[[nodiscard]] bool str_view_skip_optional_whitespace(StrView* str_view) {
 
-	return utf8proc_category(code_point) == (*(utf8proc_category_t*)data_ptr);
-}
+	while(!str_view_is_eof(*str_view)) {
 
-[[nodiscard]] bool str_view_skip_optional_whitespace(StrView* str_view) {
+		int32_t current_codepoint = str_view->start[str_view->offset];
 
-	utf8proc_category_t cat = UTF8PROC_CATEGORY_ZS;
+		if(!is_space_separator(current_codepoint)) {
+			return true;
+		}
 
-	return str_view_skip_while(str_view, category_delimiter, (void*)&cat);
+		str_view->offset++;
+	}
+
+	return true;
 }
 
 [[nodiscard]] ConstStrView get_const_str_view_from_str_view(StrView input) {
@@ -228,6 +232,11 @@ typedef bool (*DelimiterFn)(int32_t code_point, void* data_ptr);
 	    (Codepoints){ .data = str_view.start, .size = str_view.length });
 }
 
+[[nodiscard]] char* alloc_normalized_string(ConstStrView str_view) {
+	return alloc_normalized_string_from_codepoints(
+	    (Codepoints){ .data = str_view.start, .size = str_view.length });
+}
+
 [[nodiscard]] bool str_view_get_substring_by_amount(StrView* str_view, ConstStrView* result,
                                                     size_t amount) {
 
@@ -45,8 +45,13 @@ typedef enum : uint8_t {
 
 [[nodiscard]] ConstStrView get_const_str_view_from_str_view(StrView input);
 
+// allocated with malloc, for the callers of the library
 [[nodiscard]] char* get_normalized_string(ConstStrView str_view);
 
+// the same as get_normalized_string, but allocated with ass_arena_malloc, so that it can be owned
+// by a parse result, free it with ass_free
+[[nodiscard]] char* alloc_normalized_string(ConstStrView str_view);
+
 [[nodiscard]] bool str_view_get_substring_by_amount(StrView* str_view, ConstStrView* result,
                                                     size_t amount);
 
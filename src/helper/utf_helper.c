@@ -1,9 +1,11 @@
 
 
 #include "./utf_helper.h"
+#include "./arena.h"
 
 #include <errno.h>
 #include <iconv.h>
+#include <string.h>
 #include <utf8proc.h>
 
 CodepointsResult get_codepoints_from_utf8(SizedPtr ptr) {
@@ -13,7 +15,7 @@ CodepointsResult get_codepoints_from_utf8(SizedPtr ptr) {
 			                       .data = { .result = (Codepoints){ .size = 0, .data = NULL } } };
 	}
 
-	utf8proc_int32_t* buffer = malloc(sizeof(utf8proc_int32_t) * ptr.len);
+	utf8proc_int32_t* buffer = ass_malloc(sizeof(utf8proc_int32_t) * ptr.len);
 
 	if(!buffer) {
 		return (CodepointsResult){ .has_error = true, .data = { .error = "failed malloc" } };
@@ -24,17 +26,17 @@ CodepointsResult get_codepoints_from_utf8(SizedPtr ptr) {
 	    0); // NOLINT(cppcoreguidelines-narrowing-conversions,clang-analyzer-optin.core.EnumCastOutOfRange)
 
 	if(result < 0) {
-		free(buffer);
+		ass_free(buffer);
 		return (CodepointsResult){ .has_error = true,
 			                       .data = { .error = utf8proc_errmsg(result) } };
 	}
 
 	if((size_t)result != ptr.len) {
 		// truncate the buffer
-		void* new_buffer = realloc(buffer, sizeof(utf8proc_int32_t) * result);
+		void* new_buffer = ass_realloc(buffer, sizeof(utf8proc_int32_t) * result);
 
 		if(!new_buffer) {
-			free(buffer);
+			ass_free(buffer);
 			return (CodepointsResult){ .has_error = true, .data = { .error = "failed realloc" } };
 		}
 		buffer = new_buffer;
@@ -47,83 +49,127 @@ CodepointsResult get_codepoints_from_utf8(SizedPtr ptr) {
 
 #define CHUNK_SIZE_CONVERSION (1 << 14)
 
-[[nodiscard]] static SizedPtr convert_to_utf8_from_format(SizedPtr ptr, const char* format) {
+[[nodiscard]] Utf8Converter get_utf8_converter(const AssAllocator* allocator) {
+	return (Utf8Converter){ .allocator = allocator,
+		                    .format = NULL,
+		                    .conversion_state = NULL,
+		                    .buffer = { .data = NULL, .len = 0 } };
+}
+
+void free_utf8_converter(Utf8Converter* converter) {
+
+	if(converter->format != NULL) {
+		iconv_close((iconv_t)converter->conversion_state);
+	}
+
+	allocator_free(converter->allocator, converter->buffer.data);
+
+	*converter = get_utf8_converter(converter->allocator);
+}
+
+// the conversion state is only opened again, if the format changed
+[[nodiscard]] static const char* open_conversion_state(Utf8Converter* converter,
+                                                      const char* format) {
+
+	if(converter->format != NULL && strcmp(converter->format, format) == 0) {
+		// resets the shift state, that a previous conversion may have left behind
+		iconv((iconv_t)converter->conversion_state, NULL, NULL, NULL, NULL);
+		return NULL;
+	}
+
+	if(converter->format != NULL) {
+		iconv_close((iconv_t)converter->conversion_state);
+		converter->format = NULL;
+	}
+
 	iconv_t conversion_state = iconv_open("UTF-8", format);
 	if(conversion_state == (iconv_t)(-1)) {
-		return ptr_error("iconv conversion allocation failed, invalid formats");
+		return "iconv conversion allocation failed, invalid formats";
 	}
 
-	SizedPtr result_ptr = { .data = NULL, .len = 0 };
+	converter->conversion_state = (void*)conversion_state;
+	converter->format = format;
+
+	return NULL;
+}
+
+// the result points into the buffer of the converter
+[[nodiscard]] static SizedPtr convert_to_utf8_from_format(SizedPtr ptr, const char* format,
+                                                          Utf8Converter* converter) {
+
+	const char* open_error = open_conversion_state(converter, format);
+	if(open_error != NULL) {
+		return ptr_error(open_error);
+	}
+
+	iconv_t conversion_state = (iconv_t)converter->conversion_state;
+
+	if(converter->buffer.len < CHUNK_SIZE_CONVERSION) {
+		void* start_buf =
+		    allocator_realloc(converter->allocator, converter->buffer.data, CHUNK_SIZE_CONVERSION);
+		if(!start_buf) {
+			return ptr_error("allocation error");
+		}
 
-	void* start_buf = malloc(CHUNK_SIZE_CONVERSION);
-	if(!start_buf) {
-		iconv_close(conversion_state);
-		return ptr_error("allocation error");
+		converter->buffer = (SizedPtr){ .data = start_buf, .len = CHUNK_SIZE_CONVERSION };
 	}
 
-	result_ptr.data = start_buf;
+	SizedPtr result_ptr = { .data = converter->buffer.data, .len = 0 };
 
 	char* inbuf = (char*)ptr.data;
 	size_t inbytesleft = ptr.len;
 
 	char* outbuf = (char*)result_ptr.data;
-	size_t outbytesleft = CHUNK_SIZE_CONVERSION;
+	size_t outbytesleft = converter->buffer.len;
 
 	while(true) {
 
 		size_t result = iconv(conversion_state, &inbuf, &inbytesleft, &outbuf, &outbytesleft);
 		if(result == (size_t)(-1)) {
 			if(errno == EILSEQ) {
-				iconv_close(conversion_state);
-				free(result_ptr.data);
 				return ptr_error("invalid byte sequence detected, while converting");
 			} else if(errno == EINVAL) {
-				free(result_ptr.data);
-				iconv_close(conversion_state);
 				return ptr_error("byte sequence terminated too early, while converting");
 			} else if(errno == E2BIG) {
 				// more buffer needed!
 
-				result_ptr.len = result_ptr.len + (CHUNK_SIZE_CONVERSION - outbytesleft);
+				result_ptr.len = converter->buffer.len - outbytesleft;
 
-				char* new_buffer =
-				    (char*)realloc(result_ptr.data, result_ptr.len + CHUNK_SIZE_CONVERSION);
+				size_t new_size = converter->buffer.len + CHUNK_SIZE_CONVERSION;
+
+				char* new_buffer = (char*)allocator_realloc(converter->allocator,
+				                                            converter->buffer.data, new_size);
 
 				if(!new_buffer) {
-					iconv_close(conversion_state);
-					free(result_ptr.data);
 					return ptr_error("realloc error");
 				}
 
+				converter->buffer = (SizedPtr){ .data = new_buffer, .len = new_size };
 				result_ptr.data = new_buffer;
-				outbytesleft = CHUNK_SIZE_CONVERSION;
+				outbytesleft = new_size - result_ptr.len;
 				outbuf = new_buffer + result_ptr.len;
 				continue;
 
 			} else {
-				iconv_close(conversion_state);
-				free(result_ptr.data);
 				return ptr_error("unknown error occurred, while converting");
 			}
 		}
 
-		size_t added_size = result == 0 ? (CHUNK_SIZE_CONVERSION - outbytesleft) : result;
-
-		result_ptr.len = result_ptr.len + added_size;
+		result_ptr.len = converter->buffer.len - outbytesleft;
 		break;
 	}
 
 	if(result_ptr.len == 0) {
-		free(result_ptr.data);
 		result_ptr.data = NULL;
 	}
 
-	iconv_close(conversion_state);
 	return result_ptr;
 }
 
-[[nodiscard]] CodepointsResult get_codepoints_from_format(SizedPtr ptr, const char* format) {
-	SizedPtr converted_result = convert_to_utf8_from_format(ptr, format);
+[[nodiscard]] static CodepointsResult get_codepoints_with_converter(SizedPtr ptr,
+                                                                   const char* format,
+                                                                   Utf8Converter* converter) {
+	SizedPtr converted_result = convert_to_utf8_from_format(ptr, format, converter);
 
 	if(is_ptr_error(converted_result)) {
 
@@ -131,9 +177,16 @@ CodepointsResult get_codepoints_from_utf8(SizedPtr ptr) {
 			                       .data = { .error = ptr_get_error(converted_result) } };
 	}
 
-	CodepointsResult result = get_codepoints_from_utf8(converted_result);
+	return get_codepoints_from_utf8(converted_result);
+}
+
+[[nodiscard]] CodepointsResult get_codepoints_from_format(SizedPtr ptr, const char* format) {
 
-	free_sized_ptr(converted_result);
+	Utf8Converter converter = get_utf8_converter(get_thread_allocation().allocator);
+
+	CodepointsResult result = get_codepoints_with_converter(ptr, format, &converter);
+
+	free_utf8_converter(&converter);
 
 	return result;
 }
@@ -143,21 +196,36 @@ CodepointsResult get_codepoints_from_utf8(SizedPtr ptr) {
 }
 
 [[nodiscard]] CodepointsResult get_codepoints_from_utf32(SizedPtr ptr, bool big_endian) {
-	return get_codepoints_from_format(ptr, big_endian ? "UTF-16BE" : "UTF-16LE");
+	return get_codepoints_from_format(ptr, big_endian ? "UTF-32BE" : "UTF-32LE");
+}
+
+[[nodiscard]] CodepointsResult
+get_codepoints_from_utf16_with_converter(SizedPtr ptr, bool big_endian, Utf8Converter* converter) {
+	return get_codepoints_with_converter(ptr, big_endian ? "UTF-16BE" : "UTF-16LE", converter);
+}
+
+[[nodiscard]] CodepointsResult
+get_codepoints_from_utf32_with_converter(SizedPtr ptr, bool big_endian, Utf8Converter* converter) {
+	return get_codepoints_with_converter(ptr, big_endian ? "UTF-32BE" : "UTF-32LE", converter);
 }
 
 void free_codepoints(Codepoints data) {
 	if(data.data != NULL) {
-		free(data.data);
+		ass_free(data.data);
 	}
 }
 
 #define CHUNK_SIZE_NORMALIZE 256
 
-char* get_normalized_string_from_codepoints(Codepoints codepoints) {
+typedef void* (*ReallocFunction)(void* ptr, size_t size);
+
+typedef void (*FreeFunction)(void* ptr);
+
+[[nodiscard]] static char* normalize_codepoints(Codepoints codepoints, ReallocFunction realloc_fn,
+                                               FreeFunction free_fn) {
 
 	size_t buffer_size = CHUNK_SIZE_NORMALIZE;
-	uint8_t* buffer = (uint8_t*)malloc(buffer_size);
+	uint8_t* buffer = (uint8_t*)realloc_fn(NULL, buffer_size);
 
 	size_t current_size = 0;
 
@@ -169,10 +237,10 @@ char* get_normalized_string_from_codepoints(Codepoints codepoints) {
 
 		if(buffer_size - current_size < 4) {
 			buffer_size = buffer_size + CHUNK_SIZE_NORMALIZE;
-			uint8_t* new_buffer = (uint8_t*)realloc(buffer, buffer_size);
+			uint8_t* new_buffer = (uint8_t*)realloc_fn(buffer, buffer_size);
 
 			if(!new_buffer) {
-				free(buffer);
+				free_fn(buffer);
 				return NULL;
 			}
 
@@ -182,7 +250,7 @@ char* get_normalized_string_from_codepoints(Codepoints codepoints) {
 		long result = utf8proc_encode_char(codepoints.data[i], buffer + current_size);
 
 		if(result <= 0) {
-			free(buffer);
+			free_fn(buffer);
 			return NULL;
 		}
 
@@ -191,10 +259,10 @@ char* get_normalized_string_from_codepoints(Codepoints codepoints) {
 
 	if(buffer_size - current_size < 1) {
 		buffer_size = buffer_size + 1;
-		uint8_t* new_buffer = (uint8_t*)realloc(buffer, buffer_size);
+		uint8_t* new_buffer = (uint8_t*)realloc_fn(buffer, buffer_size);
 
 		if(!new_buffer) {
-			free(buffer);
+			free_fn(buffer);
 			return NULL;
 		}
 
@@ -205,3 +273,11 @@ char* get_normalized_string_from_codepoints(Codepoints codepoints) {
 
 	return (char*)buffer;
 }
+
+char* get_normalized_string_from_codepoints(Codepoints codepoints) {
+	return normalize_codepoints(codepoints, realloc, free);
+}
+
+char* alloc_normalized_string_from_codepoints(Codepoints codepoints) {
+	return normalize_codepoints(codepoints, ass_arena_realloc, ass_free);
+}
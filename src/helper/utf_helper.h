@@ -5,6 +5,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "./allocator.h"
 #include "./sized_ptr.h"
 
 typedef struct {
@@ -26,6 +27,31 @@ typedef struct {
 
 [[nodiscard]] CodepointsResult get_codepoints_from_utf32(SizedPtr ptr, bool big_endian);
 
+// keeps the iconv conversion state and the output buffer between conversions, so that a lot of
+// files can be converted without setting them up again every time
+typedef struct {
+	const AssAllocator* allocator;
+	// the source format of the open conversion state, NULL, if there is none
+	const char* format;
+	void* conversion_state;
+	// the len is the capacity
+	SizedPtr buffer;
+} Utf8Converter;
+
+[[nodiscard]] Utf8Converter get_utf8_converter(const AssAllocator* allocator);
+
+void free_utf8_converter(Utf8Converter* converter);
+
+[[nodiscard]] CodepointsResult
+get_codepoints_from_utf16_with_converter(SizedPtr ptr, bool big_endian, Utf8Converter* converter);
+
+[[nodiscard]] CodepointsResult
+get_codepoints_from_utf32_with_converter(SizedPtr ptr, bool big_endian, Utf8Converter* converter);
+
 void free_codepoints(Codepoints data);
 
 [[nodiscard]] char* get_normalized_string_from_codepoints(Codepoints codepoints);
+
+// the same as get_normalized_string_from_codepoints, but allocated with ass_arena_malloc, so that
+// it can be owned by a parse result, free it with ass_free
+[[nodiscard]] char* alloc_normalized_string_from_codepoints(Codepoints codepoints);
@@ -84,17 +84,6 @@
 
 		if(current_codepoint < (unsigned char)'0' || current_codepoint > (unsigned char)'9') {
 
-			char* value_name = get_normalized_string(value);
-
-			if(!value_name) {
-				*error_ptr = STATIC_ERROR("allocation error");
-				return 0;
-			}
-
-			char* result_buffer = NULL;
-			FORMAT_STRING_DEFAULT(&result_buffer, "error, not a valid decimal number: %s",
-			                      value_name);
-
 			if(allow_number_truncating) {
 				assert(warnings != NULL);
 				// check if the number is not empty
@@ -109,13 +98,13 @@
 
 					if(local_error.message == NULL) {
 
-						WarningEntry warning = { .type = WarningTypeSimple,
-							                     .data = { .simple = result_buffer } };
+						TruncatedNumberWarning truncated_number = { .value = value,
+							                                        .truncated_value = result };
 
-						stbds_arrput(warnings->entries, warning);
+						WarningEntry warning = { .type = WarningTypeTruncatedNumber,
+							                     .data = { .truncated_number = truncated_number } };
 
-						free_error_struct(local_error);
-						free(value_name);
+						stbds_arrput(warnings->entries, warning);
 
 						// return the truncated number
 						*error_ptr = NO_ERROR();
@@ -126,7 +115,18 @@
 				}
 			}
 
-			free(value_name);
+			char* value_name = alloc_normalized_string(value);
+
+			if(!value_name) {
+				*error_ptr = STATIC_ERROR("allocation error");
+				return 0;
+			}
+
+			char* result_buffer = NULL;
+			FORMAT_STRING_DEFAULT(&result_buffer, "error, not a valid decimal number: %s",
+			                      value_name);
+
+			ass_free(value_name);
 
 			*error_ptr = DYNAMIC_ERROR(result_buffer);
 			return 0;
@@ -464,6 +464,39 @@
 	return time;
 }
 
+[[nodiscard]] static inline bool is_ascii_digit(int32_t codepoint) {
+	return codepoint >= (unsigned char)'0' && codepoint <= (unsigned char)'9';
+}
+
+[[nodiscard]] static inline uint8_t get_two_digit_value(const int32_t* data) {
+	return (uint8_t)(((data[0] - '0') * 10) + (data[1] - '0'));
+}
+
+[[nodiscard]] bool parse_str_as_fixed_width_time(ConstStrView value, AssTime* result) {
+
+	// layout: H:MM:SS.CC, where the last separator may also be ':'
+
+	if(value.length != 10) {
+		return false;
+	}
+
+	const int32_t* data = value.start;
+
+	if(!is_ascii_digit(data[0]) || data[1] != ':' || !is_ascii_digit(data[2]) ||
+	   !is_ascii_digit(data[3]) || data[4] != ':' || !is_ascii_digit(data[5]) ||
+	   !is_ascii_digit(data[6]) || (data[7] != '.' && data[7] != ':') ||
+	   !is_ascii_digit(data[8]) || !is_ascii_digit(data[9])) {
+		return false;
+	}
+
+	*result = (AssTime){ .hour = (uint8_t)(data[0] - '0'),
+		                 .min = get_two_digit_value(data + 2),
+		                 .sec = get_two_digit_value(data + 5),
+		                 .hundred = get_two_digit_value(data + 8) };
+
+	return true;
+}
+
 [[nodiscard]] ScriptType parse_str_as_script_type(ConstStrView value, ErrorStruct* error_ptr) {
 
 	if(str_view_eq_ascii(value, "V4.00") || str_view_eq_ascii(value, "v4.00")) {
@@ -38,6 +38,9 @@
 [[nodiscard]] AssTime parse_str_as_time(ConstStrView value, ErrorStruct* error_ptr,
                                         Warnings* warnings);
 
+// only succeeds for well formed times, for error messages use parse_str_as_time
+[[nodiscard]] bool parse_str_as_fixed_width_time(ConstStrView value, AssTime* result);
+
 [[nodiscard]] ScriptType parse_str_as_script_type(ConstStrView value, ErrorStruct* error_ptr);
 
 [[nodiscard]] WrapStyle parse_str_as_wrap_style(ConstStrView value, ErrorStruct* error_ptr,
@@ -2,6 +2,7 @@
 #define ASS_PARSER_C_INTERNAL_USAGE
 
 #include "./parser.h"
+#include "../helper/arena.h"
 #include "../helper/io.h"
 #include "../helper/macros.h"
 #include "../helper/utf_helper.h"
@@ -9,10 +10,15 @@
 
 #undef ASS_PARSER_C_INTERNAL_USAGE
 
+#include <pthread.h>
 #include <stb/ds.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 [[nodiscard]] const char* get_script_type_name(ScriptType script_type) {
 	switch(script_type) {
@@ -108,6 +114,13 @@ typedef enum : uint8_t {
 	}
 }
 
+// the bytes of a source, that couldn't be decoded or edited, so that later edits can still be
+// applied to them, an empty source is present, but has no data
+typedef struct {
+	bool is_present;
+	SizedPtr data;
+} RawSource;
+
 struct AssParseResultImpl {
 	bool is_error;
 	union {
@@ -115,12 +128,67 @@ struct AssParseResultImpl {
 		AssResult ok;
 	} data;
 	Warnings warnings;
+	RecoveredErrors recovered_errors;
 	Codepoints allocated_codepoints;
+	AssSections sections;
+	ParseSettings settings;
+	FileType file_type;
+	// owns every array and string of the result, except the codepoints and the error messages
+	Arena arena;
+	// the codepoints only contain the referenced strings, see parse_result_compact
+	bool is_compacted;
+	// only present in error results, that have no codepoints
+	RawSource raw_source;
+};
+
+struct AssParserContextImpl {
+	const AssAllocator* allocator;
+	// the len is the capacity, the data of every file source is read into it
+	SizedPtr file_buffer;
+	Utf8Converter converter;
 };
 
-[[nodiscard]] static SizedPtr get_data_from_source(AssSource source) {
+[[nodiscard]] AssParserContext* alloc_parser_context(const AssAllocator* allocator) {
+
+	AssParserContext* context =
+	    (AssParserContext*)allocator_malloc(allocator, sizeof(AssParserContext));
+
+	if(!context) {
+		return NULL;
+	}
+
+	context->allocator = allocator;
+	context->file_buffer = (SizedPtr){ .data = NULL, .len = 0 };
+	context->converter = get_utf8_converter(allocator);
+
+	return context;
+}
+
+void free_parser_context(AssParserContext* context) {
+
+	if(context == NULL) {
+		return;
+	}
+
+	allocator_free(context->allocator, context->file_buffer.data);
+	free_utf8_converter(&(context->converter));
+
+	allocator_free(context->allocator, context);
+}
+
+// with a context, file data is read into its buffer and must not be freed
+[[nodiscard]] static bool is_source_data_owned(AssSource source, const AssParserContext* context) {
+	return context == NULL || source.type != AssSourceTypeFile;
+}
+
+[[nodiscard]] static SizedPtr get_data_from_source(AssSource source, AssParserContext* context) {
 	switch(source.type) {
 		case AssSourceTypeFile: {
+			if(context != NULL) {
+				return read_entire_file_into_buffer(source.data.file, &(context->file_buffer),
+				                                    context->allocator);
+			}
+
 			return read_entire_file(source.data.file);
 		}
 		case AssSourceTypeStr: {
@@ -176,6 +244,185 @@ struct AssParseResultImpl {
 	return str_view_is_eof(str_view);
 }
 
+// a parsed format line is compiled once into a list of field instructions, so that every line
+// only needs to run these in order, instead of dispatching on the format of every field
+
+typedef struct {
+	bool allow_number_truncating;
+	Warnings* warnings;
+} FieldParseContext;
+
+typedef void (*FieldParseFn)(ConstStrView value, void* destination, ErrorStruct* error_ptr,
+                             FieldParseContext context);
+
+typedef struct {
+	FieldParseFn parse_fn;
+	size_t offset;
+	const char* name;
+	// the field takes the rest of the line, commas included
+	bool is_remainder;
+} FieldInstruction;
+
+typedef struct {
+	STBDS_ARRAY(FieldInstruction) instructions;
+	// the format line lists every field in the order of the spec, that almost every file uses,
+	// these lines are handled by an unrolled parser
+	bool is_canonical;
+	// the AssEventFields, that are only split and decoded on first use
+	uint8_t lazy_fields;
+	// the amount of event instructions, after which start, end, layer and style are known, so that
+	// the event filter can be applied, 0 if the format is missing the field (or one of the times),
+	// as the default value is known from the start
+	size_t time_fields_end;
+	size_t layer_field_end;
+	size_t style_field_end;
+} FieldProgram;
+
+#define CANONICAL_STYLE_FIELD_COUNT 23
+
+#define CANONICAL_EVENT_FIELD_COUNT 10
+
+// fills the positions of at most 'amount' commas and returns how many were found
+[[nodiscard]] static size_t find_field_delimiters(StrView line_view, size_t* positions,
+                                                  size_t amount) {
+
+	size_t found = 0;
+
+	for(size_t i = line_view.offset; i < line_view.length && found < amount; ++i) {
+		if(line_view.start[i] == ',') {
+			positions[found] = i;
+			found++;
+		}
+	}
+
+	return found;
+}
+
+// splits the line into 'amount' + 1 fields, the last one is the rest of the line
+static void get_fields_from_delimiters(StrView line_view, const size_t* positions, size_t amount,
+                                       ConstStrView* values) {
+
+	size_t field_start = line_view.offset;
+
+	for(size_t i = 0; i < amount; ++i) {
+		values[i] = (ConstStrView){ .start = line_view.start + field_start,
+			                        .length = positions[i] - field_start };
+		field_start = positions[i] + 1;
+	}
+
+	values[amount] = (ConstStrView){ .start = line_view.start + field_start,
+		                             .length = line_view.length - field_start };
+}
+
+#define FIELD_INSTRUCTION(EntryType, member, fn, field_name) \
+	((FieldInstruction){ .parse_fn = (fn), \
+	                     .offset = offsetof(EntryType, member), \
+	                     .name = (field_name), \
+	                     .is_remainder = false })
+
+static void parse_field_as_str(ConstStrView value, void* destination, ErrorStruct* error_ptr,
+                               FieldParseContext context) {
+	UNUSED(context);
+	*(FinalStr*)destination = value;
+	*error_ptr = NO_ERROR();
+}
+
+static void parse_field_as_unsigned_number(ConstStrView value, void* destination,
+                                           ErrorStruct* error_ptr, FieldParseContext context) {
+	*(size_t*)destination = parse_str_as_unsigned_number(value, error_ptr, context.warnings);
+}
+
+static void parse_field_as_truncated_unsigned_number(ConstStrView value, void* destination,
+                                                     ErrorStruct* error_ptr,
+                                                     FieldParseContext context) {
+	*(size_t*)destination = parse_str_as_unsigned_number_with_option(
+	    value, error_ptr, context.allow_number_truncating, context.warnings);
+}
+
+static void parse_field_as_double(ConstStrView value, void* destination, ErrorStruct* error_ptr,
+                                  FieldParseContext context) {
+	*(double*)destination = parse_str_as_double(value, error_ptr, context.warnings);
+}
+
+static void parse_field_as_bool(ConstStrView value, void* destination, ErrorStruct* error_ptr,
+                                FieldParseContext context) {
+	UNUSED(context);
+	*(bool*)destination = parse_str_as_bool(value, error_ptr);
+}
+
+static void parse_field_as_color(ConstStrView value, void* destination, ErrorStruct* error_ptr,
+                                 FieldParseContext context) {
+	UNUSED(context);
+	*(AssColor*)destination = parse_str_as_color(value, error_ptr);
+}
+
+static void parse_field_as_border_style(ConstStrView value, void* destination,
+                                        ErrorStruct* error_ptr, FieldParseContext context) {
+	*(BorderStyle*)destination = parse_str_as_border_style(value, error_ptr, context.warnings);
+}
+
+static void parse_field_as_style_alignment(ConstStrView value, void* destination,
+                                           ErrorStruct* error_ptr, FieldParseContext context) {
+	*(AssAlignment*)destination = parse_str_as_style_alignment(value, error_ptr, context.warnings);
+}
+
+static void parse_field_as_margin_value(ConstStrView value, void* destination,
+                                        ErrorStruct* error_ptr, FieldParseContext context) {
+	*(MarginValue*)destination = parse_str_as_margin_value(value, error_ptr, context.warnings);
+}
+
+static void parse_field_as_time(ConstStrView value, void* destination, ErrorStruct* error_ptr,
+                                FieldParseContext context) {
+	*(AssTime*)destination = parse_str_as_time(value, error_ptr, context.warnings);
+}
+
+// lazily decoded fields are left untouched, decode_event_fields splits the line again
+static void parse_field_as_pending(ConstStrView value, void* destination, ErrorStruct* error_ptr,
+                                   FieldParseContext context) {
+	UNUSED(value);
+	UNUSED(destination);
+	UNUSED(context);
+	*error_ptr = NO_ERROR();
+}
+
+[[nodiscard]] static ErrorStruct get_field_parse_error(const char* field_name, ConstStrView value,
+                                                       ErrorStruct error) {
+
+	char* value_name = alloc_normalized_string(value);
+
+	if(!value_name) {
+		free_error_struct(error);
+		return STATIC_ERROR("allocation error");
+	}
+
+	char* result_buffer = NULL;
+	FORMAT_STRING_DEFAULT(&result_buffer, "While parsing field '%s' with value '%s': %s",
+	                      field_name, value_name, error.message);
+
+	ass_free(value_name);
+	free_error_struct(error);
+	return DYNAMIC_ERROR(result_buffer);
+}
+
+[[nodiscard]] static ErrorStruct run_field_instruction(FieldInstruction instruction,
+                                                       ConstStrView value, void* entry,
+                                                       FieldParseContext context) {
+
+	ErrorStruct error = NO_ERROR();
+
+	instruction.parse_fn(value, (uint8_t*)entry + instruction.offset, &error, context);
+
+	if(error.message == NULL) {
+		return NO_ERROR();
+	}
+
+	return get_field_parse_error(instruction.name, value, error);
+}
+
+static void free_field_program(FieldProgram program) {
+	stbds_arrfree(program.instructions);
+}
+
 [[nodiscard]] static ErrorStruct
 parse_format_line_for_styles(StrView* line_view, STBDS_ARRAY(AssStyleFormat) * format_result) {
 
@@ -244,7 +491,7 @@ parse_format_line_for_styles(StrView* line_view, STBDS_ARRAY(AssStyleFormat) * f
 			format = AssStyleFormatEncoding;
 		} else {
 
-			char* key_name = get_normalized_string(key);
+			char* key_name = alloc_normalized_string(key);
 
 			if(!key_name) {
 				return STATIC_ERROR("allocation error");
@@ -255,7 +502,7 @@ parse_format_line_for_styles(StrView* line_view, STBDS_ARRAY(AssStyleFormat) * f
 			                      "unrecognized format key %s in format line in styles section",
 			                      key_name);
 
-			free(key_name);
+			ass_free(key_name);
 
 			return DYNAMIC_ERROR(result_buffer);
 		}
@@ -266,165 +513,251 @@ parse_format_line_for_styles(StrView* line_view, STBDS_ARRAY(AssStyleFormat) * f
 	return NO_ERROR();
 }
 
-[[nodiscard]] static ErrorStruct
-parse_style_line_for_styles(StrView* line_view, const STBDS_ARRAY(AssStyleFormat) const format_spec,
-                            AssStyles* styles_result, ParseSettings settings, Warnings* warnings) {
+[[nodiscard]] static FieldInstruction get_instruction_for_style_format(AssStyleFormat format) {
+
+#define STYLE_INSTRUCTION(member, fn) \
+	FIELD_INSTRUCTION(AssStyleEntry, member, fn, get_name_for_style_format(format))
+
+	switch(format) {
+		case AssStyleFormatName: return STYLE_INSTRUCTION(name, parse_field_as_str);
+		case AssStyleFormatFontname: return STYLE_INSTRUCTION(fontname, parse_field_as_str);
+		case AssStyleFormatFontsize:
+			return STYLE_INSTRUCTION(fontsize, parse_field_as_truncated_unsigned_number);
+		case AssStyleFormatPrimaryColour:
+			return STYLE_INSTRUCTION(primary_colour, parse_field_as_color);
+		case AssStyleFormatSecondaryColour:
+			return STYLE_INSTRUCTION(secondary_colour, parse_field_as_color);
+		case AssStyleFormatOutlineColour:
+			return STYLE_INSTRUCTION(outline_colour, parse_field_as_color);
+		case AssStyleFormatBackColour: return STYLE_INSTRUCTION(back_colour, parse_field_as_color);
+		case AssStyleFormatBold: return STYLE_INSTRUCTION(bold, parse_field_as_bool);
+		case AssStyleFormatItalic: return STYLE_INSTRUCTION(italic, parse_field_as_bool);
+		case AssStyleFormatUnderline: return STYLE_INSTRUCTION(underline, parse_field_as_bool);
+		case AssStyleFormatStrikeOut: return STYLE_INSTRUCTION(strike_out, parse_field_as_bool);
+		case AssStyleFormatScaleX:
+			return STYLE_INSTRUCTION(scale_x, parse_field_as_unsigned_number);
+		case AssStyleFormatScaleY:
+			return STYLE_INSTRUCTION(scale_y, parse_field_as_unsigned_number);
+		case AssStyleFormatSpacing: return STYLE_INSTRUCTION(spacing, parse_field_as_double);
+		case AssStyleFormatAngle: return STYLE_INSTRUCTION(angle, parse_field_as_double);
+		case AssStyleFormatBorderStyle:
+			return STYLE_INSTRUCTION(border_style, parse_field_as_border_style);
+		case AssStyleFormatOutline: return STYLE_INSTRUCTION(outline, parse_field_as_double);
+		case AssStyleFormatShadow: return STYLE_INSTRUCTION(shadow, parse_field_as_double);
+		case AssStyleFormatAlignment:
+			return STYLE_INSTRUCTION(alignment, parse_field_as_style_alignment);
+		case AssStyleFormatMarginL:
+			return STYLE_INSTRUCTION(margin_l, parse_field_as_unsigned_number);
+		case AssStyleFormatMarginR:
+			return STYLE_INSTRUCTION(margin_r, parse_field_as_unsigned_number);
+		case AssStyleFormatMarginV:
+			return STYLE_INSTRUCTION(margin_v, parse_field_as_unsigned_number);
+		case AssStyleFormatEncoding:
+			return STYLE_INSTRUCTION(encoding, parse_field_as_unsigned_number);
+		default: {
+			UNREACHABLE();
+		}
+	}
+
+#undef STYLE_INSTRUCTION
+}
+
+[[nodiscard]] static FieldProgram
+compile_format_for_styles(const STBDS_ARRAY(AssStyleFormat) const format_spec) {
+
+	FieldProgram program = { .instructions = STBDS_ARRAY_EMPTY, .is_canonical = false };
 
 	size_t field_size = stbds_arrlenu(format_spec);
 
+	stbds_arrsetcap(program.instructions, field_size);
+
+	program.is_canonical = field_size == CANONICAL_STYLE_FIELD_COUNT;
+
+	for(size_t i = 0; i < field_size; ++i) {
+		AssStyleFormat format = format_spec[i];
+
+		stbds_arrput(program.instructions, get_instruction_for_style_format(format));
+
+		// the enum order of the formats is the canonical order of the spec
+		if(format != i) {
+			program.is_canonical = false;
+		}
+	}
+
+	return program;
+}
+
+// returns false, if the line doesn't have exactly one comma between all fields, these lines go
+// through the generic program, as that produces the correct error messages
+[[nodiscard]] static bool parse_canonical_style_line(StrView* line_view, AssStyleEntry* entry,
+                                                     FieldParseContext context,
+                                                     ErrorStruct* error_ptr) {
+
+	size_t positions[CANONICAL_STYLE_FIELD_COUNT] = {};
+
+	if(find_field_delimiters(*line_view, positions, CANONICAL_STYLE_FIELD_COUNT) !=
+	   CANONICAL_STYLE_FIELD_COUNT - 1) {
+		return false;
+	}
+
+	// a trailing comma ends the line one field too early
+	if(positions[CANONICAL_STYLE_FIELD_COUNT - 2] + 1 == line_view->length) {
+		return false;
+	}
+
+	ConstStrView values[CANONICAL_STYLE_FIELD_COUNT] = {};
+	get_fields_from_delimiters(*line_view, positions, CANONICAL_STYLE_FIELD_COUNT - 1, values);
+
+	line_view->offset = line_view->length;
+
+	*error_ptr = NO_ERROR();
+	ErrorStruct error = NO_ERROR();
+	Warnings* warnings = context.warnings;
+
+#define PARSE_CANONICAL_STYLE_FIELD(format, statement) \
+	do { \
+		statement; \
+		if(error.message != NULL) { \
+			*error_ptr = get_field_parse_error(get_name_for_style_format(format), \
+			                                   values[format], error); \
+			return true; \
+		} \
+	} while(false)
+
+	entry->name = values[AssStyleFormatName];
+	entry->fontname = values[AssStyleFormatFontname];
+	PARSE_CANONICAL_STYLE_FIELD(AssStyleFormatFontsize,
+	                            entry->fontsize = parse_str_as_unsigned_number_with_option(
+	                                values[AssStyleFormatFontsize], &error,
+	                                context.allow_number_truncating, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(
+	    AssStyleFormatPrimaryColour,
+	    entry->primary_colour = parse_str_as_color(values[AssStyleFormatPrimaryColour], &error));
+	PARSE_CANONICAL_STYLE_FIELD(AssStyleFormatSecondaryColour,
+	                            entry->secondary_colour = parse_str_as_color(
+	                                values[AssStyleFormatSecondaryColour], &error));
+	PARSE_CANONICAL_STYLE_FIELD(
+	    AssStyleFormatOutlineColour,
+	    entry->outline_colour = parse_str_as_color(values[AssStyleFormatOutlineColour], &error));
+	PARSE_CANONICAL_STYLE_FIELD(
+	    AssStyleFormatBackColour,
+	    entry->back_colour = parse_str_as_color(values[AssStyleFormatBackColour], &error));
+	PARSE_CANONICAL_STYLE_FIELD(
+	    AssStyleFormatBold, entry->bold = parse_str_as_bool(values[AssStyleFormatBold], &error));
+	PARSE_CANONICAL_STYLE_FIELD(
+	    AssStyleFormatItalic,
+	    entry->italic = parse_str_as_bool(values[AssStyleFormatItalic], &error));
+	PARSE_CANONICAL_STYLE_FIELD(
+	    AssStyleFormatUnderline,
+	    entry->underline = parse_str_as_bool(values[AssStyleFormatUnderline], &error));
+	PARSE_CANONICAL_STYLE_FIELD(
+	    AssStyleFormatStrikeOut,
+	    entry->strike_out = parse_str_as_bool(values[AssStyleFormatStrikeOut], &error));
+	PARSE_CANONICAL_STYLE_FIELD(AssStyleFormatScaleX,
+	                            entry->scale_x = parse_str_as_unsigned_number(
+	                                values[AssStyleFormatScaleX], &error, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(AssStyleFormatScaleY,
+	                            entry->scale_y = parse_str_as_unsigned_number(
+	                                values[AssStyleFormatScaleY], &error, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(
+	    AssStyleFormatSpacing,
+	    entry->spacing = parse_str_as_double(values[AssStyleFormatSpacing], &error, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(
+	    AssStyleFormatAngle,
+	    entry->angle = parse_str_as_double(values[AssStyleFormatAngle], &error, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(AssStyleFormatBorderStyle,
+	                            entry->border_style = parse_str_as_border_style(
+	                                values[AssStyleFormatBorderStyle], &error, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(
+	    AssStyleFormatOutline,
+	    entry->outline = parse_str_as_double(values[AssStyleFormatOutline], &error, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(
+	    AssStyleFormatShadow,
+	    entry->shadow = parse_str_as_double(values[AssStyleFormatShadow], &error, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(AssStyleFormatAlignment,
+	                            entry->alignment = parse_str_as_style_alignment(
+	                                values[AssStyleFormatAlignment], &error, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(AssStyleFormatMarginL,
+	                            entry->margin_l = parse_str_as_unsigned_number(
+	                                values[AssStyleFormatMarginL], &error, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(AssStyleFormatMarginR,
+	                            entry->margin_r = parse_str_as_unsigned_number(
+	                                values[AssStyleFormatMarginR], &error, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(AssStyleFormatMarginV,
+	                            entry->margin_v = parse_str_as_unsigned_number(
+	                                values[AssStyleFormatMarginV], &error, warnings));
+	PARSE_CANONICAL_STYLE_FIELD(AssStyleFormatEncoding,
+	                            entry->encoding = parse_str_as_unsigned_number(
+	                                values[AssStyleFormatEncoding], &error, warnings));
+
+#undef PARSE_CANONICAL_STYLE_FIELD
+
+	return true;
+}
+
+[[nodiscard]] static ErrorStruct parse_style_line_for_styles(StrView* line_view,
+                                                             const FieldProgram program,
+                                                             AssStyles* styles_result,
+                                                             ParseSettings settings,
+                                                             Warnings* warnings) {
+
+	size_t field_size = stbds_arrlenu(program.instructions);
+
 	AssStyleEntry entry = {};
 
+	FieldParseContext context = { .allow_number_truncating =
+		                              settings.strict_settings.allow_number_truncating,
+		                          .warnings = warnings };
+
 	if(!str_view_skip_optional_whitespace(line_view)) {
 		return STATIC_ERROR("skip whitespace error");
 	}
 
-	size_t i = 0;
-	for(; !str_view_is_eof(*line_view); ++i) {
+	if(program.is_canonical) {
+		ErrorStruct error = NO_ERROR();
 
-		ConstStrView value = {};
-		if(!str_view_get_substring_by_char_delimiter(line_view, &value, ',', true)) {
-			return STATIC_ERROR("implementation error");
+		if(parse_canonical_style_line(line_view, &entry, context, &error)) {
+			if(error.message != NULL) {
+				return error;
+			}
+
+			stbds_arrput(styles_result->entries, entry);
+			return NO_ERROR();
 		}
+	}
+
+	for(size_t i = 0; i < field_size; ++i) {
 
-		if(i >= field_size) {
+		if(str_view_is_eof(*line_view)) {
 
 			char* result_buffer = NULL;
 			FORMAT_STRING_DEFAULT(&result_buffer,
-			                      "error, too many fields in the style line, the format line "
-			                      "specified %lu, but we are already at %lu",
-			                      field_size, (i + 1));
+			                      "error, too few fields in the style line, the format line "
+			                      "specified %lu, but we only have %lu",
+			                      field_size, i);
 
 			return DYNAMIC_ERROR(result_buffer);
 		}
 
-		ErrorStruct error = NO_ERROR();
-
-		AssStyleFormat format = format_spec[i];
-
-		switch(format) {
-			case AssStyleFormatName: {
-				entry.name = value;
-				break;
-			}
-			case AssStyleFormatFontname: {
-				entry.fontname = value;
-				break;
-			}
-			case AssStyleFormatFontsize: {
-				entry.fontsize = parse_str_as_unsigned_number_with_option(
-				    value, &error, settings.strict_settings.allow_number_truncating, warnings);
-				break;
-			}
-			case AssStyleFormatPrimaryColour: {
-				entry.primary_colour = parse_str_as_color(value, &error);
-				break;
-			}
-			case AssStyleFormatSecondaryColour: {
-				entry.secondary_colour = parse_str_as_color(value, &error);
-				break;
-			}
-			case AssStyleFormatOutlineColour: {
-				entry.outline_colour = parse_str_as_color(value, &error);
-				break;
-			}
-			case AssStyleFormatBackColour: {
-				entry.back_colour = parse_str_as_color(value, &error);
-				break;
-			}
-			case AssStyleFormatBold: {
-				entry.bold = parse_str_as_bool(value, &error);
-				break;
-			}
-			case AssStyleFormatItalic: {
-				entry.italic = parse_str_as_bool(value, &error);
-				break;
-			}
-			case AssStyleFormatUnderline: {
-				entry.underline = parse_str_as_bool(value, &error);
-				break;
-			}
-			case AssStyleFormatStrikeOut: {
-				entry.strike_out = parse_str_as_bool(value, &error);
-				break;
-			}
-			case AssStyleFormatScaleX: {
-				entry.scale_x = parse_str_as_unsigned_number(value, &error, warnings);
-				break;
-			}
-			case AssStyleFormatScaleY: {
-				entry.scale_y = parse_str_as_unsigned_number(value, &error, warnings);
-				break;
-			}
-			case AssStyleFormatSpacing: {
-				entry.spacing = parse_str_as_double(value, &error, warnings);
-				break;
-			}
-			case AssStyleFormatAngle: {
-				entry.angle = parse_str_as_double(value, &error, warnings);
-				break;
-			}
-			case AssStyleFormatBorderStyle: {
-				entry.border_style = parse_str_as_border_style(value, &error, warnings);
-				break;
-			}
-			case AssStyleFormatOutline: {
-				entry.outline = parse_str_as_double(value, &error, warnings);
-				break;
-			}
-			case AssStyleFormatShadow: {
-				entry.shadow = parse_str_as_double(value, &error, warnings);
-				break;
-			}
-			case AssStyleFormatAlignment: {
-				entry.alignment = parse_str_as_style_alignment(value, &error, warnings);
-				break;
-			}
-			case AssStyleFormatMarginL: {
-				entry.margin_l = parse_str_as_unsigned_number(value, &error, warnings);
-				break;
-			}
-			case AssStyleFormatMarginR: {
-				entry.margin_r = parse_str_as_unsigned_number(value, &error, warnings);
-				break;
-			}
-			case AssStyleFormatMarginV: {
-				entry.margin_v = parse_str_as_unsigned_number(value, &error, warnings);
-				break;
-			}
-			case AssStyleFormatEncoding: {
-				entry.encoding = parse_str_as_unsigned_number(value, &error, warnings);
-				break;
-			}
-			default: {
-				UNREACHABLE();
-			}
+		ConstStrView value = {};
+		if(!str_view_get_substring_by_char_delimiter(line_view, &value, ',', true)) {
+			return STATIC_ERROR("implementation error");
 		}
 
-		if(error.message != NULL) {
-
-			char* value_name = get_normalized_string(value);
+		ErrorStruct error = run_field_instruction(program.instructions[i], value, &entry, context);
 
-			if(!value_name) {
-				return STATIC_ERROR("allocation error");
-			}
-
-			char* result_buffer = NULL;
-			FORMAT_STRING_DEFAULT(&result_buffer, "While parsing field '%s' with value '%s': %s",
-			                      get_name_for_style_format(format), value_name, error.message);
-
-			free(value_name);
-			free_error_struct(error);
-			return DYNAMIC_ERROR(result_buffer);
+		if(error.message != NULL) {
+			return error;
 		}
 	}
 
-	if(i != field_size) {
+	if(!str_view_is_eof(*line_view)) {
 
 		char* result_buffer = NULL;
 		FORMAT_STRING_DEFAULT(&result_buffer,
-		                      "error, too few fields in the style line, the format line "
-		                      "specified %lu, but we only have %lu",
-		                      field_size, i);
+		                      "error, too many fields in the style line, the format line "
+		                      "specified %lu, but we are already at %lu",
+		                      field_size, (field_size + 1));
 
 		return DYNAMIC_ERROR(result_buffer);
 	}
@@ -434,106 +767,172 @@ parse_style_line_for_styles(StrView* line_view, const STBDS_ARRAY(AssStyleFormat
 	return NO_ERROR();
 }
 
-[[nodiscard]] static ErrorStruct parse_styles(AssStyles* ass_styles, StrView* data_view,
-                                              ParseSettings settings, LineType line_type,
-                                              Warnings* warnings) {
+// returns false, if the error has to end the parse, otherwise the error is owned by errors now
+[[nodiscard]] static bool recover_from_error(ErrorStruct error, const char* section,
+                                             FinalStr location, ParseSettings settings,
+                                             RecoveredErrors* errors) {
 
-	AssStyles styles = { .entries = STBDS_ARRAY_EMPTY };
+	if(!settings.recover_from_errors) {
+		return false;
+	}
 
-	STBDS_ARRAY(AssStyleFormat) style_format = STBDS_ARRAY_EMPTY;
+	if(settings.max_recovered_errors != 0 &&
+	   stbds_arrlenu(errors->entries) >= settings.max_recovered_errors) {
+		return false;
+	}
 
-	while(!str_view_starts_with_ascii_or_eof(*data_view, "[")) {
+	RecoveredError entry = { .section = section, .location = location, .error = error };
 
-		ConstStrView line = {};
-		if(!str_view_get_substring_until_eol(data_view, &line, line_type, true)) {
-			return STATIC_ERROR("implementation error");
+	stbds_arrput(errors->entries, entry);
+
+	return true;
+}
+
+typedef struct {
+	STBDS_ARRAY(AssStyleFormat) style_format;
+	FieldProgram style_program;
+	AssStyles styles;
+} StylesParseState;
+
+[[nodiscard]] static ErrorStruct parse_line_for_styles(StylesParseState* state, ConstStrView line,
+                                                       ParseSettings settings,
+                                                       Warnings* warnings) {
+
+	StrView line_view = get_str_view_from_const_str_view(line);
+
+	ConstStrView field = {};
+	if(!str_view_get_substring_by_char_delimiter(&line_view, &field, ':', false)) {
+		return STATIC_ERROR("end of line before ':' in line parsing in styles section");
+	}
+
+	if(str_view_eq_ascii(field, "Format")) {
+
+		if(stbds_arrlenu(state->style_format) != 0) {
+			return STATIC_ERROR("multiple format fields detected in the styles section, this is "
+			                    "not allowed");
 		}
 
-		// parse line
-		{
+		ErrorStruct format_line_error =
+		    parse_format_line_for_styles(&line_view, &(state->style_format));
 
-			if(line.length == 0) {
-				continue;
-			}
+		if(format_line_error.message != NULL) {
+			// a partial format is never used
+			stbds_arrfree(state->style_format);
+			return format_line_error;
+		}
 
-			StrView line_view = get_str_view_from_const_str_view(line);
+		state->style_program = compile_format_for_styles(state->style_format);
 
-			ConstStrView field = {};
-			if(!str_view_get_substring_by_char_delimiter(&line_view, &field, ':', false)) {
-				return STATIC_ERROR("end of line before ':' in line parsing in styles section");
-			}
+		return NO_ERROR();
+	}
 
-			if(str_view_eq_ascii(field, "Format")) {
+	if(str_view_eq_ascii(field, "Style")) {
 
-				if(stbds_arrlenu(style_format) != 0) {
-					return STATIC_ERROR(
-					    "multiple format fields detected in the styles section, this is not "
-					    "allowed");
-				}
+		if(stbds_arrlenu(state->style_format) == 0) {
+			return STATIC_ERROR(
+			    "no format line occurred before the style line in the styles section, "
+			    "this is an error");
+		}
 
-				ErrorStruct format_line_error =
-				    parse_format_line_for_styles(&line_view, &style_format);
+		return parse_style_line_for_styles(&line_view, state->style_program, &(state->styles),
+		                                   settings, warnings);
+	}
 
-				if(format_line_error.message != NULL) {
-					return format_line_error;
-				}
+	if(settings.strict_settings.allow_additional_fields) {
 
-			} else if(str_view_eq_ascii(field, "Style")) {
+		UnexpectedFieldWarning unexpected_field = { .field = field, .section = "styles" };
 
-				if(stbds_arrlenu(style_format) == 0) {
-					return STATIC_ERROR(
-					    "no format line occurred before the style line in the styles section, "
-					    "this is an error");
-				}
+		WarningEntry warning = { .type = WarningTypeUnexpectedField,
+			                     .data = { .unexpected_field = unexpected_field } };
 
-				ErrorStruct style_parse_error = parse_style_line_for_styles(
-				    &line_view, style_format, &styles, settings, warnings);
+		stbds_arrput(warnings->entries, warning);
 
-				if(style_parse_error.message != NULL) {
-					return style_parse_error;
-				}
+		return NO_ERROR();
+	}
 
-			} else {
+	char* field_name = alloc_normalized_string(field);
 
-				char* field_name = get_normalized_string(field);
+	if(!field_name) {
+		return STATIC_ERROR("allocation error");
+	}
 
-				if(!field_name) {
-					return STATIC_ERROR("allocation error");
-				}
+	char* result_buffer = NULL;
+	FORMAT_STRING_DEFAULT(&result_buffer, "unexpected field in styles section: '%s'", field_name);
 
-				char* result_buffer = NULL;
-				FORMAT_STRING_DEFAULT(&result_buffer, "unexpected field in styles section: '%s'",
-				                      field_name);
+	ass_free(field_name);
+	return DYNAMIC_ERROR(result_buffer);
+}
 
-				if(settings.strict_settings.allow_additional_fields) {
+static void free_styles_parse_state(StylesParseState state) {
+	stbds_arrfree(state.styles.entries);
+	stbds_arrfree(state.style_format);
+	free_field_program(state.style_program);
+}
 
-					UnexpectedFieldWarning unexpected_field = { .field = field,
-						                                        .section = "styles" };
+[[nodiscard]] static ErrorStruct parse_style_lines(StylesParseState* state, StrView* data_view,
+                                                   ParseSettings settings, LineType line_type,
+                                                   Warnings* warnings, RecoveredErrors* errors) {
 
-					WarningEntry warning = { .type = WarningTypeUnexpectedField,
-						                     .data = { .unexpected_field = unexpected_field } };
+	while(!str_view_starts_with_ascii_or_eof(*data_view, "[")) {
 
-					stbds_arrput(warnings->entries, warning);
+		ConstStrView line = {};
+		if(!str_view_get_substring_until_eol(data_view, &line, line_type, true)) {
+			return STATIC_ERROR("implementation error");
+		}
 
-					free(result_buffer);
-					free(field_name);
-					continue;
-				}
+		if(line.length == 0) {
+			continue;
+		}
 
-				free(field_name);
-				return DYNAMIC_ERROR(result_buffer);
+		ErrorStruct line_error = parse_line_for_styles(state, line, settings, warnings);
+
+		if(line_error.message != NULL) {
+			if(!recover_from_error(line_error, "styles", line, settings, errors)) {
+				return line_error;
 			}
-		}
 
-		// end of line parse
+			// without a format, none of the following lines can be parsed
+			if(stbds_arrlenu(state->style_format) == 0) {
+				data_view->offset = data_view->length;
+				return NO_ERROR();
+			}
+		}
 
 		if(str_view_is_eof(*data_view)) {
 			break;
 		}
 	}
 
-	stbds_arrfree(style_format);
-	*ass_styles = styles;
+	return NO_ERROR();
+}
+
+[[nodiscard]] static ErrorStruct parse_styles(AssStyles* ass_styles, StrView* data_view,
+                                              ParseSettings settings, LineType line_type,
+                                              size_t line_count, Warnings* warnings,
+                                              RecoveredErrors* errors) {
+
+	StylesParseState state = {
+		.style_format = STBDS_ARRAY_EMPTY,
+		.style_program = { .instructions = STBDS_ARRAY_EMPTY },
+		.styles = { .entries = STBDS_ARRAY_EMPTY },
+	};
+
+	// every style line is a line of this section, so this is an upper bound, that is only off by
+	// the format line and empty lines
+	if(line_count > 0) {
+		stbds_arrsetcap(state.styles.entries, line_count);
+	}
+
+	ErrorStruct error = parse_style_lines(&state, data_view, settings, line_type, warnings, errors);
+
+	if(error.message != NULL) {
+		free_styles_parse_state(state);
+		return error;
+	}
+
+	stbds_arrfree(state.style_format);
+	free_field_program(state.style_program);
+	*ass_styles = state.styles;
 	return NO_ERROR();
 	// end of script info
 }
@@ -601,18 +1000,7 @@ static FinalStr
 				if(str_view_eq_str_view(field_str, field)) {
 					found_field = true;
 
-					char* field_name = get_normalized_string(field);
-
-					if(!field_name) {
-						FREE_AT_END();
-						return STATIC_ERROR("allocation error");
-					}
-
-					char* result_buffer = NULL;
-					FORMAT_STRING_DEFAULT(
-					    &result_buffer, "duplicate field in script info section: '%s'", field_name);
-
-					if(settings.strict_settings.script_info.allow_duplicate_fields) {
+					if(settings.strict_settings.script_info.allow_duplicate_fields) {
 
 						DuplicateFieldWarning duplicate_field = { .field = field,
 							                                      .section = "script info" };
@@ -622,12 +1010,21 @@ static FinalStr
 
 						stbds_arrput(warnings->entries, warning);
 
-						free(result_buffer);
-						free(field_name);
 						break;
 					}
 
-					free(field_name);
+					char* field_name = alloc_normalized_string(field);
+
+					if(!field_name) {
+						FREE_AT_END();
+						return STATIC_ERROR("allocation error");
+					}
+
+					char* result_buffer = NULL;
+					FORMAT_STRING_DEFAULT(
+					    &result_buffer, "duplicate field in script info section: '%s'", field_name);
+
+					ass_free(field_name);
 					FREE_AT_END();
 					return DYNAMIC_ERROR(result_buffer);
 				}
@@ -691,17 +1088,6 @@ static FinalStr
 				script_info.ycbcr_matrix = value;
 			} else {
 
-				char* field_name = get_normalized_string(field);
-
-				if(!field_name) {
-					FREE_AT_END();
-					return STATIC_ERROR("allocation error");
-				}
-
-				char* result_buffer = NULL;
-				FORMAT_STRING_DEFAULT(&result_buffer,
-				                      "unexpected field in script info section: '%s'", field_name);
-
 				if(settings.strict_settings.allow_additional_fields) {
 
 					UnexpectedFieldWarning unexpected_field = { .field = field,
@@ -712,26 +1098,35 @@ static FinalStr
 
 					stbds_arrput(warnings->entries, warning);
 
-					free(result_buffer);
-					free(field_name);
 					continue;
 				}
 
-				free(field_name);
+				char* field_name = alloc_normalized_string(field);
+
+				if(!field_name) {
+					FREE_AT_END();
+					return STATIC_ERROR("allocation error");
+				}
+
+				char* result_buffer = NULL;
+				FORMAT_STRING_DEFAULT(&result_buffer,
+				                      "unexpected field in script info section: '%s'", field_name);
+
+				ass_free(field_name);
 				FREE_AT_END();
 				return DYNAMIC_ERROR(result_buffer);
 			}
 
 			if(error.message != NULL) {
 
-				char* field_name = get_normalized_string(field);
+				char* field_name = alloc_normalized_string(field);
 
 				if(!field_name) {
 					FREE_AT_END();
 					return STATIC_ERROR("allocation error");
 				}
 
-				char* value_name = get_normalized_string(value);
+				char* value_name = alloc_normalized_string(value);
 
 				if(!value_name) {
 					FREE_AT_END();
@@ -744,8 +1139,8 @@ static FinalStr
 				                      value_name, error.message);
 
 				free_error_struct(error);
-				free(field_name);
-				free(value_name);
+				ass_free(field_name);
+				ass_free(value_name);
 				FREE_AT_END();
 				return DYNAMIC_ERROR(result_buffer);
 			}
@@ -765,15 +1160,12 @@ static FinalStr
 	{
 
 		if(script_info.script_type == ScriptTypeUnknown) {
-			const char* error = "missing script type in script info section";
-
 			if(settings.strict_settings.script_info.allow_missing_script_type) {
-				WarningEntry warning = { .type = WarningTypeSimple,
-					                     .data = { .simple = strdup(error) } };
+				WarningEntry warning = { .type = WarningTypeMissingScriptType };
 
-				stbds_arrput(warnings->entries, warning); // NOLINT(clang-analyzer-unix.Malloc)
+				stbds_arrput(warnings->entries, warning);
 			} else {
-				return STATIC_ERROR(error);
+				return STATIC_ERROR("missing script type in script info section");
 			}
 		} else if(script_info.script_type != ScriptTypeV4Plus) {
 
@@ -799,30 +1191,100 @@ static FinalStr
 	// end of script info
 }
 
-[[nodiscard]] static ErrorStruct skip_section(StrView* data_view, LineType line_type) {
+// only the first character of every line matters here, so this just scans for the line endings
+static void skip_section(StrView* data_view, LineType line_type, size_t* line_count) {
 
-	while(!str_view_starts_with_ascii_or_eof(*data_view, "[")) {
+	// the last character of every line ending
+	int32_t line_end = line_type == LineTypeCr ? '\r' : '\n';
 
-		ConstStrView line = {};
-		if(!str_view_get_substring_until_eol(data_view, &line, line_type, true)) {
+	size_t position = data_view->offset;
+
+	while(position < data_view->length && data_view->start[position] != '[') {
+
+		while(position < data_view->length && data_view->start[position] != line_end) {
+			++position;
+		}
+
+		if(position < data_view->length) {
+			++position;
+		}
+
+		(*line_count)++;
+	}
+
+	data_view->offset = position;
+}
+
+// with first_section_only, the table ends after the first section and the rest of the data is
+// never looked at
+[[nodiscard]] static ErrorStruct build_section_table(StrView data_view, LineType line_type,
+                                                     bool first_section_only,
+                                                     AssSections* sections_result) {
+
+	AssSections sections = { .entries = STBDS_ARRAY_EMPTY };
+
+	while(!str_view_is_eof(data_view)) {
+
+		size_t header_start = data_view.offset;
+
+		if(!str_view_expect_ascii(&data_view, "[")) {
+			stbds_arrfree(sections.entries);
 			return STATIC_ERROR("implementation error");
 		}
 
-		// skip the line
-		UNUSED(line);
+		ConstStrView section_name = {};
+		if(!str_view_get_substring_by_char_delimiter(&data_view, &section_name, ']', false)) {
+			stbds_arrfree(sections.entries);
+			return STATIC_ERROR("script section not terminated by ']'");
+		}
 
-		if(str_view_is_eof(*data_view)) {
+		if(!str_view_expect_newline(&data_view, line_type)) {
+			stbds_arrfree(sections.entries);
+			return STATIC_ERROR("no newline after section name");
+		}
+
+		AssSectionEntry entry = { .name = section_name,
+			                      .header_start = header_start,
+			                      .start = data_view.offset,
+			                      .end = data_view.offset,
+			                      .line_count = 0,
+			                      .parsed = false };
+
+		skip_section(&data_view, line_type, &entry.line_count);
+
+		entry.end = data_view.offset;
+
+		stbds_arrput(sections.entries, entry);
+
+		if(first_section_only) {
 			break;
 		}
 	}
 
+	*sections_result = sections;
 	return NO_ERROR();
 }
 
+[[nodiscard]] static StrView get_str_view_for_section(Codepoints data, AssSectionEntry section) {
+	return (StrView){ .start = data.data, .offset = section.start, .length = section.end };
+}
+
+static void free_extra_section_entry(ExtraSectionEntry entry) {
+	size_t hm_length = stbds_shlenu(entry.fields);
+
+	for(size_t i = 0; i < hm_length; ++i) {
+		SectionFieldEntry hm_entry = entry.fields[i];
+
+		ass_free(hm_entry.key);
+	}
+
+	stbds_shfree(entry.fields);
+}
+
 [[nodiscard]] static ErrorStruct extra_section(ConstStrView section_name, StrView* data_view,
                                                ExtraSections* extra_sections, LineType line_type) {
 
-	char* section_name_str = get_normalized_string(section_name);
+	char* section_name_str = alloc_normalized_string(section_name);
 
 	if(section_name_str == NULL) {
 		return STATIC_ERROR("alloc error");
@@ -831,10 +1293,17 @@ static FinalStr
 	ExtraSectionHashMapEntry extra_section = { .key = section_name_str,
 		                                       .value = { .fields = STBDS_HASH_MAP_EMPTY } };
 
+#define FREE_AT_END() \
+	do { \
+		free_extra_section_entry(extra_section.value); \
+		ass_free(section_name_str); \
+	} while(false)
+
 	while(!str_view_starts_with_ascii_or_eof(*data_view, "[")) {
 
 		ConstStrView line = {};
 		if(!str_view_get_substring_until_eol(data_view, &line, line_type, true)) {
+			FREE_AT_END();
 			return STATIC_ERROR("implementation error");
 		}
 
@@ -850,20 +1319,23 @@ static FinalStr
 
 			ConstStrView field = {};
 			if(!str_view_get_substring_by_char_delimiter(&line_view, &field, ':', false)) {
+				FREE_AT_END();
 				return STATIC_ERROR("end of line before ':' in line parsing in extra section");
 			}
 
 			if(!str_view_skip_optional_whitespace(&line_view)) {
+				FREE_AT_END();
 				return STATIC_ERROR("skip whitespace error");
 			}
 
 			ConstStrView key = {};
 
 			if(!str_view_get_substring_until_eof(&line_view, &key)) {
+				FREE_AT_END();
 				return STATIC_ERROR("eof error");
 			}
 
-			field_entry.key = get_normalized_string(field);
+			field_entry.key = alloc_normalized_string(field);
 			field_entry.value = key;
 
 			stbds_shputs(extra_section.value.fields, field_entry);
@@ -874,6 +1346,8 @@ static FinalStr
 		}
 	}
 
+#undef FREE_AT_END
+
 	stbds_shputs(extra_sections->entries, extra_section);
 
 	return NO_ERROR();
@@ -921,7 +1395,7 @@ parse_format_line_for_events(StrView* line_view, STBDS_ARRAY(AssEventFormat) * f
 			format = AssEventFormatText;
 		} else {
 
-			char* key_name = get_normalized_string(key);
+			char* key_name = alloc_normalized_string(key);
 
 			if(!key_name) {
 				return STATIC_ERROR("allocation error");
@@ -932,7 +1406,7 @@ parse_format_line_for_events(StrView* line_view, STBDS_ARRAY(AssEventFormat) * f
 			                      "unrecognized format key %s in format line in events section",
 			                      key_name);
 
-			free(key_name);
+			ass_free(key_name);
 			return DYNAMIC_ERROR(result_buffer);
 		}
 
@@ -942,605 +1416,4062 @@ parse_format_line_for_events(StrView* line_view, STBDS_ARRAY(AssEventFormat) * f
 	return NO_ERROR();
 }
 
-[[nodiscard]] static ErrorStruct parse_event_line_for_events(EventType type, StrView* line_view,
-                                                             const STBDS_ARRAY(AssEventFormat)
-                                                                 const format_spec,
-                                                             AssEvents* events_result,
-                                                             Warnings* warnings) {
-
-	size_t field_size = stbds_arrlenu(format_spec);
+[[nodiscard]] static FieldInstruction get_instruction_for_event_format(AssEventFormat format) {
 
-	AssEventEntry entry = { .type = type };
+#define EVENT_INSTRUCTION(member, fn) \
+	FIELD_INSTRUCTION(AssEventEntry, member, fn, get_name_for_event_format(format))
 
-	if(!str_view_skip_optional_whitespace(line_view)) {
-		return STATIC_ERROR("skip whitespace error");
+	switch(format) {
+		case AssEventFormatLayer: return EVENT_INSTRUCTION(layer, parse_field_as_unsigned_number);
+		case AssEventFormatStart: return EVENT_INSTRUCTION(start, parse_field_as_time);
+		case AssEventFormatEnd: return EVENT_INSTRUCTION(end, parse_field_as_time);
+		case AssEventFormatStyle: return EVENT_INSTRUCTION(style, parse_field_as_str);
+		case AssEventFormatName: return EVENT_INSTRUCTION(name, parse_field_as_str);
+		case AssEventFormatMarginL: return EVENT_INSTRUCTION(margin_l, parse_field_as_margin_value);
+		case AssEventFormatMarginR: return EVENT_INSTRUCTION(margin_r, parse_field_as_margin_value);
+		case AssEventFormatMarginV: return EVENT_INSTRUCTION(margin_v, parse_field_as_margin_value);
+		case AssEventFormatEffect: return EVENT_INSTRUCTION(effect, parse_field_as_str);
+		case AssEventFormatText: {
+			// special handling fot the text field, as it may contain ","
+			FieldInstruction instruction = EVENT_INSTRUCTION(text, parse_field_as_str);
+			instruction.is_remainder = true;
+			return instruction;
+		}
+		default: {
+			UNREACHABLE();
+		}
 	}
 
-	size_t i = 0;
+#undef EVENT_INSTRUCTION
+}
 
-	for(bool are_at_end = false; !are_at_end; ++i) {
+// in the order of the AssEventField bits
+static const AssEventFormat g_lazy_event_formats[ASS_LAZY_EVENT_FIELD_COUNT] = {
+	AssEventFormatLayer,   AssEventFormatStart,   AssEventFormatEnd,
+	AssEventFormatMarginL, AssEventFormatMarginR, AssEventFormatMarginV,
+};
 
-		if(i >= field_size) {
+// returns 0 for fields, that are always decoded
+[[nodiscard]] static uint8_t get_lazy_event_field(AssEventFormat format) {
+	for(size_t i = 0; i < ASS_LAZY_EVENT_FIELD_COUNT; ++i) {
+		if(g_lazy_event_formats[i] == format) {
+			return (uint8_t)(1 << i);
+		}
+	}
 
-			char* result_buffer = NULL;
-			FORMAT_STRING_DEFAULT(&result_buffer,
-			                      "error, too many fields in the event line, the format line "
-			                      "specified %lu, but we are already at %lu",
-			                      field_size, (i + 1));
+	return 0;
+}
 
-			return DYNAMIC_ERROR(result_buffer);
-		}
+[[nodiscard]] static FieldProgram
+compile_format_for_events(const STBDS_ARRAY(AssEventFormat) const format_spec,
+                          uint8_t lazy_fields) {
 
-		AssEventFormat format = format_spec[i];
+	FieldProgram program = { .instructions = STBDS_ARRAY_EMPTY, .is_canonical = false };
 
-		// special handling fot the text field, as it may contain ","
+	size_t field_size = stbds_arrlenu(format_spec);
 
-		ConstStrView value = {};
+	stbds_arrsetcap(program.instructions, field_size);
 
-		if(format == AssEventFormatText) {
-			if(i != field_size - 1) {
-				return STATIC_ERROR(
-				    "'Text' field of event lines may only occur at the last position!");
-			}
+	program.is_canonical = field_size == CANONICAL_EVENT_FIELD_COUNT;
 
-			if(!str_view_get_substring_until_eof(line_view, &value)) {
-				return STATIC_ERROR("eof before comma in events section event line");
-			}
-			are_at_end = true;
+	bool has_start = false;
+	bool has_end = false;
 
-			// TODO(Totto): check and parse text value, for invalid escape sequences, and invald
-			// values inside {}, like eg {bogus}, or {\j} etc, or not closed {} blocks
+	for(size_t i = 0; i < field_size; ++i) {
+		AssEventFormat format = format_spec[i];
 
-		} else {
-			if(!str_view_get_substring_by_char_delimiter(line_view, &value, ',', true)) {
-				return STATIC_ERROR("implementation error");
+		FieldInstruction instruction = get_instruction_for_event_format(format);
 
-				are_at_end = true;
-			}
+		uint8_t lazy_field = get_lazy_event_field(format);
+
+		if((lazy_fields & lazy_field) != 0) {
+			instruction.parse_fn = parse_field_as_pending;
+			program.lazy_fields |= lazy_field;
 		}
 
-		ErrorStruct error = NO_ERROR();
+		if(format == AssEventFormatStart) {
+			has_start = true;
+		} else if(format == AssEventFormatEnd) {
+			has_end = true;
+		} else if(format == AssEventFormatLayer) {
+			program.layer_field_end = i + 1;
+		} else if(format == AssEventFormatStyle) {
+			program.style_field_end = i + 1;
+		}
 
-		switch(format) {
-			case AssEventFormatLayer: {
-				entry.layer = parse_str_as_unsigned_number(value, &error, warnings);
-				break;
-			}
-			case AssEventFormatStart: {
-				entry.start = parse_str_as_time(value, &error, warnings);
-				break;
-			}
-			case AssEventFormatEnd: {
-				entry.end = parse_str_as_time(value, &error, warnings);
-				break;
-			}
-			case AssEventFormatStyle: {
-				entry.style = value;
-				break;
-			}
-			case AssEventFormatName: {
-				entry.name = value;
-				break;
-			}
-			case AssEventFormatMarginL: {
-				entry.margin_l = parse_str_as_margin_value(value, &error, warnings);
-				break;
-			}
-			case AssEventFormatMarginR: {
-				entry.margin_r = parse_str_as_margin_value(value, &error, warnings);
-				break;
-			}
-			case AssEventFormatMarginV: {
-				entry.margin_v = parse_str_as_margin_value(value, &error, warnings);
-				break;
-			}
-			case AssEventFormatEffect: {
-				entry.effect = value;
-				break;
-			}
-			case AssEventFormatText: {
-				entry.text = value;
-				break;
-			}
-			default: {
-				UNREACHABLE();
-			}
+		if(has_start && has_end && program.time_fields_end == 0) {
+			program.time_fields_end = i + 1;
 		}
 
-		if(error.message != NULL) {
+		stbds_arrput(program.instructions, instruction);
 
-			char* value_name = get_normalized_string(value);
+		// the enum order of the formats is the canonical order of the spec
+		if(format != i) {
+			program.is_canonical = false;
+		}
+	}
 
-			if(!value_name) {
-				return STATIC_ERROR("allocation error");
-			}
+	return program;
+}
 
-			char* result_buffer = NULL;
-			FORMAT_STRING_DEFAULT(&result_buffer, "While parsing field '%s' with value '%s': %s",
-			                      get_name_for_event_format(format), value_name, error.message);
+[[nodiscard]] AssPackedTime get_packed_time(AssTime time) {
+	return ((((AssPackedTime)time.hour * 60) + time.min) * 60 + time.sec) * 100 + time.hundred;
+}
 
-			free_error_struct(error);
-			free(value_name);
-			return DYNAMIC_ERROR(result_buffer);
-		}
-	}
+// the hours are truncated, if they don't fit into an AssTime
+[[nodiscard]] AssTime get_unpacked_time(AssPackedTime time) {
+	return (AssTime){ .hour = (uint8_t)(time / 360000),
+		              .min = (uint8_t)((time / 6000) % 60),
+		              .sec = (uint8_t)((time / 100) % 60),
+		              .hundred = (uint8_t)(time % 100) };
+}
 
-	if(i != field_size) {
-		char* result_buffer = NULL;
-		FORMAT_STRING_DEFAULT(&result_buffer,
-		                      "error, too few fields in the event line, the format line "
-		                      "specified %lu, but we only have %lu",
-		                      field_size, i);
+[[nodiscard]] static bool is_event_in_time_window(const AssEventFilter* filter, AssTime start,
+                                                  AssTime end) {
 
-		return DYNAMIC_ERROR(result_buffer);
+	if(!filter->has_time_window) {
+		return true;
 	}
 
-	stbds_arrput(events_result->entries, entry);
+	return get_packed_time(start) < get_packed_time(filter->window_end) &&
+	       get_packed_time(end) > get_packed_time(filter->window_start);
+}
 
-	return NO_ERROR();
+[[nodiscard]] static bool is_event_type_skipped(const AssEventFilter* filter, EventType type) {
+	return (filter->skipped_types & (1U << type)) != 0;
 }
 
-[[nodiscard]] static ErrorStruct parse_events(AssEvents* ass_events, StrView* data_view,
-                                              ParseSettings settings, LineType line_type,
-                                              Warnings* warnings) {
+[[nodiscard]] static bool is_event_layer_in_range(const AssEventFilter* filter, size_t layer) {
 
-	AssEvents events = { .entries = STBDS_ARRAY_EMPTY };
+	if(!filter->has_layer_range) {
+		return true;
+	}
 
-	STBDS_ARRAY(AssEventFormat) event_format = STBDS_ARRAY_EMPTY;
+	return layer >= filter->min_layer && layer <= filter->max_layer;
+}
 
-#define FREE_AT_END() \
-	do { \
-		stbds_arrfree(events.entries); \
-		stbds_arrfree(event_format); \
-	} while(false)
+[[nodiscard]] static bool is_event_style_in_filter(const AssEventFilter* filter,
+                                                   ConstStrView style) {
 
-	while(!str_view_starts_with_ascii_or_eof(*data_view, "[")) {
+	size_t style_amount = stbds_arrlenu(filter->styles);
 
-		ConstStrView line = {};
-		if(!str_view_get_substring_until_eol(data_view, &line, line_type, true)) {
-			FREE_AT_END();
-			return STATIC_ERROR("implementation error");
+	if(style_amount == 0) {
+		return true;
+	}
+
+	for(size_t i = 0; i < style_amount; ++i) {
+		if(str_view_eq_ascii(style, filter->styles[i])) {
+			return true;
 		}
+	}
 
-		// parse line
-		{
+	return false;
+}
 
-			if(line.length == 0) {
-				continue;
-			}
+// checks the parts of the filter, whose fields are known after that many event instructions, so
+// that filtered events are skipped as early as possible, regardless of the field order
+[[nodiscard]] static bool is_event_entry_filtered_after(const FieldProgram* program,
+                                                        const AssEventFilter* filter,
+                                                        const AssEventEntry* entry,
+                                                        size_t instruction_count) {
 
-			StrView line_view = get_str_view_from_const_str_view(line);
+	if(program->time_fields_end == instruction_count &&
+	   !is_event_in_time_window(filter, entry->start, entry->end)) {
+		return true;
+	}
 
-			ConstStrView field = {};
-			if(!str_view_get_substring_by_char_delimiter(&line_view, &field, ':', false)) {
-				FREE_AT_END();
-				return STATIC_ERROR("end of line before ':' in line parsing in events section");
-			}
+	if(program->layer_field_end == instruction_count &&
+	   !is_event_layer_in_range(filter, entry->layer)) {
+		return true;
+	}
 
-			if(str_view_eq_ascii(field, "Format")) {
+	return program->style_field_end == instruction_count &&
+	       !is_event_style_in_filter(filter, entry->style);
+}
 
-				if(stbds_arrlenu(event_format) != 0) {
-					FREE_AT_END();
-					return STATIC_ERROR(
-					    "multiple format fields detected in the events section, this is not "
-					    "allowed");
-				}
+// the fields, that are filtered on, are never lazy
+[[nodiscard]] static uint8_t get_lazy_fields_for_settings(ParseSettings settings) {
 
-				ErrorStruct format_line_error =
-				    parse_format_line_for_events(&line_view, &event_format);
+	if(!settings.lazy_event_fields) {
+		return 0;
+	}
 
-				if(format_line_error.message != NULL) {
-					FREE_AT_END();
-					return format_line_error;
-				}
+	uint8_t lazy_fields = AssEventFieldAll;
 
-			} else if(str_view_eq_ascii(field, "Dialogue")) {
+	if(settings.event_filter.has_time_window) {
+		lazy_fields &= (uint8_t)~(AssEventFieldStart | AssEventFieldEnd);
+	}
 
-				if(stbds_arrlenu(event_format) == 0) {
-					FREE_AT_END();
-					return STATIC_ERROR(
-					    "no format line occurred before the style line in the events section, "
-					    "this is an error");
-				}
+	if(settings.event_filter.has_layer_range) {
+		lazy_fields &= (uint8_t)~AssEventFieldLayer;
+	}
 
-				ErrorStruct event_parse_error = parse_event_line_for_events(
-				    EventTypeDialogue, &line_view, event_format, &events, warnings);
+	return lazy_fields;
+}
 
-				if(event_parse_error.message != NULL) {
-					FREE_AT_END();
-					return event_parse_error;
-				}
+// returns false, if the line has less fields than the format, these lines go through the generic
+// program, as that produces the correct error messages
+[[nodiscard]] static bool parse_canonical_event_line(StrView* line_view, AssEventEntry* entry,
+                                                     uint8_t lazy_fields,
+                                                     const AssEventFilter* filter,
+                                                     bool* is_filtered, Warnings* warnings,
+                                                     ErrorStruct* error_ptr) {
 
-			} else if(str_view_eq_ascii(field, "Comment")) {
+	size_t positions[CANONICAL_EVENT_FIELD_COUNT - 1] = {};
 
-				if(stbds_arrlenu(event_format) == 0) {
-					FREE_AT_END();
-					return STATIC_ERROR(
-					    "no format line occurred before the style line in the events section, "
-					    "this is an error");
-				}
+	// layer, start and end are split first, so that lines outside of the time window or layer range
+	// are skipped, before the rest of the line is even looked at
+	if(find_field_delimiters(*line_view, positions, AssEventFormatStyle) != AssEventFormatStyle) {
+		return false;
+	}
 
-				ErrorStruct event_parse_error = parse_event_line_for_events(
-				    EventTypeComment, &line_view, event_format, &events, warnings);
+	ConstStrView values[CANONICAL_EVENT_FIELD_COUNT] = {};
+	get_fields_from_delimiters(*line_view, positions, AssEventFormatStyle, values);
 
-				if(event_parse_error.message != NULL) {
-					FREE_AT_END();
-					return event_parse_error;
-				}
+	*error_ptr = NO_ERROR();
+	*is_filtered = false;
+	ErrorStruct error = NO_ERROR();
 
-			} else if(str_view_eq_ascii(field, "Picture")) {
+#define PARSE_CANONICAL_EVENT_FIELD(format, statement) \
+	do { \
+		if((lazy_fields & get_lazy_event_field(format)) == 0) { \
+			statement; \
+			if(error.message != NULL) { \
+				*error_ptr = get_field_parse_error(get_name_for_event_format(format), \
+				                                   values[format], error); \
+				return true; \
+			} \
+		} \
+	} while(false)
 
-				if(stbds_arrlenu(event_format) == 0) {
-					FREE_AT_END();
-					return STATIC_ERROR(
-					    "no format line occurred before the style line in the events section, "
-					    "this is an error");
-				}
+	PARSE_CANONICAL_EVENT_FIELD(
+	    AssEventFormatLayer,
+	    entry->layer = parse_str_as_unsigned_number(values[AssEventFormatLayer], &error, warnings));
+
+	PARSE_CANONICAL_EVENT_FIELD(
+	    AssEventFormatStart,
+	    if(!parse_str_as_fixed_width_time(values[AssEventFormatStart], &(entry->start))) {
+		    entry->start = parse_str_as_time(values[AssEventFormatStart], &error, warnings);
+	    });
+
+	PARSE_CANONICAL_EVENT_FIELD(
+	    AssEventFormatEnd, if(!parse_str_as_fixed_width_time(values[AssEventFormatEnd],
+	                                                         &(entry->end))) {
+		    entry->end = parse_str_as_time(values[AssEventFormatEnd], &error, warnings);
+	    });
+
+	if(!is_event_in_time_window(filter, entry->start, entry->end) ||
+	   !is_event_layer_in_range(filter, entry->layer)) {
+		*is_filtered = true;
+		line_view->offset = line_view->length;
+		return true;
+	}
 
-				ErrorStruct event_parse_error = parse_event_line_for_events(
-				    EventTypePicture, &line_view, event_format, &events, warnings);
+	StrView rest_view = *line_view;
+	rest_view.offset = positions[AssEventFormatStyle - 1] + 1;
 
-				if(event_parse_error.message != NULL) {
-					FREE_AT_END();
-					return event_parse_error;
-				}
+	size_t rest_amount = CANONICAL_EVENT_FIELD_COUNT - 1 - AssEventFormatStyle;
 
-			} else if(str_view_eq_ascii(field, "Sound")) {
+	if(find_field_delimiters(rest_view, positions + AssEventFormatStyle, rest_amount) !=
+	   rest_amount) {
+		return false;
+	}
 
-				if(stbds_arrlenu(event_format) == 0) {
-					FREE_AT_END();
-					return STATIC_ERROR(
-					    "no format line occurred before the style line in the events section, "
-					    "this is an error");
-				}
+	get_fields_from_delimiters(*line_view, positions, CANONICAL_EVENT_FIELD_COUNT - 1, values);
 
-				ErrorStruct event_parse_error = parse_event_line_for_events(
-				    EventTypeSound, &line_view, event_format, &events, warnings);
+	line_view->offset = line_view->length;
 
-				if(event_parse_error.message != NULL) {
-					FREE_AT_END();
-					return event_parse_error;
-				}
+	entry->style = values[AssEventFormatStyle];
+	entry->name = values[AssEventFormatName];
+	entry->effect = values[AssEventFormatEffect];
+	entry->text = values[AssEventFormatText];
 
-			} else if(str_view_eq_ascii(field, "Movie")) {
+	if(!is_event_style_in_filter(filter, entry->style)) {
+		*is_filtered = true;
+		return true;
+	}
 
-				if(stbds_arrlenu(event_format) == 0) {
-					FREE_AT_END();
-					return STATIC_ERROR(
-					    "no format line occurred before the style line in the events section, "
-					    "this is an error");
-				}
+	PARSE_CANONICAL_EVENT_FIELD(AssEventFormatMarginL,
+	                            entry->margin_l = parse_str_as_margin_value(
+	                                values[AssEventFormatMarginL], &error, warnings));
+	PARSE_CANONICAL_EVENT_FIELD(AssEventFormatMarginR,
+	                            entry->margin_r = parse_str_as_margin_value(
+	                                values[AssEventFormatMarginR], &error, warnings));
+	PARSE_CANONICAL_EVENT_FIELD(AssEventFormatMarginV,
+	                            entry->margin_v = parse_str_as_margin_value(
+	                                values[AssEventFormatMarginV], &error, warnings));
 
-				ErrorStruct event_parse_error = parse_event_line_for_events(
-				    EventTypeMovie, &line_view, event_format, &events, warnings);
+#undef PARSE_CANONICAL_EVENT_FIELD
 
-				if(event_parse_error.message != NULL) {
-					FREE_AT_END();
-					return event_parse_error;
-				}
+	return true;
+}
 
-			} else if(str_view_eq_ascii(field, "Command")) {
+// the fields before the text are remembered, so that the lazy fields can be found again
+static void push_event_entry(AssEvents* events, AssEventEntry entry, const int32_t* fields_start,
+                             uint8_t lazy_fields) {
+	entry.pending_fields = lazy_fields;
+	entry.fields_length = (uint32_t)(entry.text.start - fields_start);
+	// resolved after all sections are parsed, as the styles may come later or from another thread
+	entry.style_index = ASS_STYLE_INDEX_UNKNOWN;
+	entry.name_id = ASS_STRING_ID_NONE;
+	entry.effect_id = ASS_STRING_ID_NONE;
+	entry.text_id = ASS_STRING_ID_NONE;
+	stbds_arrput(events->entries, entry);
+
+	if(entry.type == EventTypeDialogue) {
+		events->dialogue_count++;
+	} else if(entry.type == EventTypeComment) {
+		events->comment_count++;
+	}
+}
 
-				if(stbds_arrlenu(event_format) == 0) {
-					FREE_AT_END();
-					return STATIC_ERROR(
-					    "no format line occurred before the style line in the events section, "
-					    "this is an error");
-				}
+[[nodiscard]] static ErrorStruct parse_event_line_for_events(EventType type, StrView* line_view,
+                                                             const FieldProgram program,
+                                                             const AssEventFilter* filter,
+                                                             AssEvents* events_result,
+                                                             Warnings* warnings) {
 
-				ErrorStruct event_parse_error = parse_event_line_for_events(
-				    EventTypeCommand, &line_view, event_format, &events, warnings);
+	size_t field_size = stbds_arrlenu(program.instructions);
 
-				if(event_parse_error.message != NULL) {
-					FREE_AT_END();
-					return event_parse_error;
-				}
+	AssEventEntry entry = { .type = type };
 
-			} else {
+	FieldParseContext context = { .allow_number_truncating = false, .warnings = warnings };
+
+	if(is_event_type_skipped(filter, type)) {
+		line_view->offset = line_view->length;
+		return NO_ERROR();
+	}
+
+	if(!str_view_skip_optional_whitespace(line_view)) {
+		return STATIC_ERROR("skip whitespace error");
+	}
+
+	const int32_t* fields_start = line_view->start + line_view->offset;
+
+	if(program.is_canonical) {
+		ErrorStruct error = NO_ERROR();
+		bool is_filtered = false;
+
+		if(parse_canonical_event_line(line_view, &entry, program.lazy_fields, filter,
+		                              &is_filtered, warnings, &error)) {
+			if(error.message != NULL) {
+				return error;
+			}
+
+			if(!is_filtered) {
+				push_event_entry(events_result, entry, fields_start, program.lazy_fields);
+			}
+
+			return NO_ERROR();
+		}
+	}
+
+	if(is_event_entry_filtered_after(&program, filter, &entry, 0)) {
+		line_view->offset = line_view->length;
+		return NO_ERROR();
+	}
+
+	for(size_t i = 0; i < field_size; ++i) {
+
+		FieldInstruction instruction = program.instructions[i];
+
+		ConstStrView value = {};
+
+		if(instruction.is_remainder) {
+			if(i != field_size - 1) {
+				return STATIC_ERROR(
+				    "'Text' field of event lines may only occur at the last position!");
+			}
+
+			if(!str_view_get_substring_until_eof(line_view, &value)) {
+				return STATIC_ERROR("eof before comma in events section event line");
+			}
+
+			// TODO(Totto): check and parse text value, for invalid escape sequences, and invald
+			// values inside {}, like eg {bogus}, or {\j} etc, or not closed {} blocks
+
+		} else {
+			if(!str_view_get_substring_by_char_delimiter(line_view, &value, ',', true)) {
+				return STATIC_ERROR("implementation error");
+			}
+		}
+
+		ErrorStruct error = run_field_instruction(instruction, value, &entry, context);
+
+		if(error.message != NULL) {
+			return error;
+		}
+
+		if(is_event_entry_filtered_after(&program, filter, &entry, i + 1)) {
+			line_view->offset = line_view->length;
+			return NO_ERROR();
+		}
+	}
+
+	// only the text field marks the end of an event line
+	if(field_size == 0 || !program.instructions[field_size - 1].is_remainder) {
+
+		char* result_buffer = NULL;
+		FORMAT_STRING_DEFAULT(&result_buffer,
+		                      "error, too many fields in the event line, the format line "
+		                      "specified %lu, but we are already at %lu",
+		                      field_size, (field_size + 1));
+
+		return DYNAMIC_ERROR(result_buffer);
+	}
+
+	push_event_entry(events_result, entry, fields_start, program.lazy_fields);
+
+	return NO_ERROR();
+}
+
+typedef struct {
+	STBDS_ARRAY(AssEventFormat) event_format;
+	FieldProgram event_program;
+	AssEvents events;
+} EventsParseState;
+
+static void free_events_parse_state(EventsParseState state) {
+	stbds_arrfree(state.events.entries);
+	stbds_arrfree(state.event_format);
+	free_field_program(state.event_program);
+}
+
+// returns false, if the field is not the name of an event line
+[[nodiscard]] static bool get_event_type_for_field(ConstStrView field, EventType* type) {
+
+	if(str_view_eq_ascii(field, "Dialogue")) {
+		*type = EventTypeDialogue;
+	} else if(str_view_eq_ascii(field, "Comment")) {
+		*type = EventTypeComment;
+	} else if(str_view_eq_ascii(field, "Picture")) {
+		*type = EventTypePicture;
+	} else if(str_view_eq_ascii(field, "Sound")) {
+		*type = EventTypeSound;
+	} else if(str_view_eq_ascii(field, "Movie")) {
+		*type = EventTypeMovie;
+	} else if(str_view_eq_ascii(field, "Command")) {
+		*type = EventTypeCommand;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+[[nodiscard]] static ErrorStruct parse_line_for_events(EventsParseState* state, ConstStrView line,
+                                                       ParseSettings settings,
+                                                       Warnings* warnings) {
+
+	StrView line_view = get_str_view_from_const_str_view(line);
+
+	ConstStrView field = {};
+	if(!str_view_get_substring_by_char_delimiter(&line_view, &field, ':', false)) {
+		return STATIC_ERROR("end of line before ':' in line parsing in events section");
+	}
+
+	if(str_view_eq_ascii(field, "Format")) {
+
+		if(stbds_arrlenu(state->event_format) != 0) {
+			return STATIC_ERROR("multiple format fields detected in the events section, this is "
+			                    "not allowed");
+		}
+
+		ErrorStruct format_line_error =
+		    parse_format_line_for_events(&line_view, &(state->event_format));
+
+		if(format_line_error.message != NULL) {
+			// a partial format is never used
+			stbds_arrfree(state->event_format);
+			return format_line_error;
+		}
+
+		state->event_program = compile_format_for_events(state->event_format,
+		                                                 get_lazy_fields_for_settings(settings));
+
+		return NO_ERROR();
+	}
+
+	EventType type = EventTypeDialogue;
+
+	if(get_event_type_for_field(field, &type)) {
+
+		if(stbds_arrlenu(state->event_format) == 0) {
+			return STATIC_ERROR(
+			    "no format line occurred before the style line in the events section, "
+			    "this is an error");
+		}
+
+		return parse_event_line_for_events(type, &line_view, state->event_program,
+		                                   &(settings.event_filter), &(state->events), warnings);
+	}
+
+	if(settings.strict_settings.allow_additional_fields) {
+
+		UnexpectedFieldWarning unexpected_field = { .field = field, .section = "events" };
+
+		WarningEntry warning = { .type = WarningTypeUnexpectedField,
+			                     .data = { .unexpected_field = unexpected_field } };
+
+		stbds_arrput(warnings->entries, warning);
+
+		return NO_ERROR();
+	}
+
+	char* field_name = alloc_normalized_string(field);
+
+	if(!field_name) {
+		return STATIC_ERROR("allocation error");
+	}
+
+	char* result_buffer = NULL;
+	FORMAT_STRING_DEFAULT(&result_buffer, "unexpected field in events section: '%s'", field_name);
+
+	ass_free(field_name);
+	return DYNAMIC_ERROR(result_buffer);
+}
+
+[[nodiscard]] static ErrorStruct parse_event_lines(EventsParseState* state, StrView* data_view,
+                                                   ParseSettings settings, LineType line_type,
+                                                   bool stop_after_format, Warnings* warnings,
+                                                   RecoveredErrors* errors) {
+
+	while(!str_view_starts_with_ascii_or_eof(*data_view, "[")) {
+
+		ConstStrView line = {};
+		if(!str_view_get_substring_until_eol(data_view, &line, line_type, true)) {
+			return STATIC_ERROR("implementation error");
+		}
+
+		if(line.length == 0) {
+			continue;
+		}
+
+		bool had_format = stbds_arrlenu(state->event_format) != 0;
+
+		ErrorStruct line_error = parse_line_for_events(state, line, settings, warnings);
+
+		if(line_error.message != NULL) {
+			if(!recover_from_error(line_error, "events", line, settings, errors)) {
+				return line_error;
+			}
+
+			// without a format, none of the following lines can be parsed
+			if(stbds_arrlenu(state->event_format) == 0) {
+				data_view->offset = data_view->length;
+				return NO_ERROR();
+			}
+		} else if(stop_after_format && !had_format && stbds_arrlenu(state->event_format) != 0) {
+			return NO_ERROR();
+		}
+
+		if(str_view_is_eof(*data_view)) {
+			break;
+		}
+	}
+
+	return NO_ERROR();
+}
+
+#define THREAD_ARENA_ERROR "couldn't create the arena of a thread"
+
+// every thread allocates in an arena of its own, that is merged into the arena of the result at
+// the end, so that no arena is changed by two threads at the same time, returns false, if the
+// arena couldn't be created
+[[nodiscard]] static bool use_thread_arena(Arena* thread_arena, ThreadAllocation result_allocation,
+                                           ThreadAllocation* previous_allocation) {
+
+	if(result_allocation.arena != NULL &&
+	   !init_arena(thread_arena, result_allocation.allocator)) {
+		return false;
+	}
+
+	*previous_allocation = set_thread_allocation(
+	    (ThreadAllocation){ .allocator = result_allocation.allocator,
+	                        .arena = result_allocation.arena != NULL ? thread_arena : NULL });
+
+	return true;
+}
+
+static void end_thread_arena(Arena* thread_arena, ThreadAllocation result_allocation,
+                             ThreadAllocation previous_allocation) {
+
+	set_thread_allocation(previous_allocation);
+
+	if(result_allocation.arena != NULL) {
+		merge_arena(result_allocation.arena, thread_arena);
+		// the blocks belong to the result now, so this only destroys the mutex
+		free_arena(thread_arena);
+	}
+}
+
+// below this amount of lines per thread, starting a thread costs more, than it saves
+#define MIN_EVENT_LINES_PER_THREAD 4096
+
+typedef struct {
+	StrView data_view;
+	ParseSettings settings;
+	LineType line_type;
+	// shares the format and program of the section, only the events are owned by the chunk
+	EventsParseState state;
+	Warnings warnings;
+	RecoveredErrors errors;
+	ErrorStruct error;
+	ThreadAllocation result_allocation;
+	pthread_t thread;
+	bool thread_started;
+} EventsChunk;
+
+[[nodiscard]] static size_t get_event_chunk_count(ParseSettings settings, size_t line_count) {
+
+	size_t chunk_count = line_count / MIN_EVENT_LINES_PER_THREAD;
+
+	if(chunk_count > settings.thread_count) {
+		chunk_count = settings.thread_count;
+	}
+
+	return chunk_count < 1 ? 1 : chunk_count;
+}
+
+[[nodiscard]] static size_t get_next_line_start(StrView data_view, size_t position,
+                                                LineType line_type) {
+
+	// the last character of every line ending
+	int32_t line_end = line_type == LineTypeCr ? '\r' : '\n';
+
+	for(size_t i = position; i < data_view.length; ++i) {
+		if(data_view.start[i] == line_end) {
+			return i + 1;
+		}
+	}
+
+	return data_view.length;
+}
+
+static void* parse_events_chunk_thread(void* arg) {
+
+	EventsChunk* chunk = (EventsChunk*)arg;
+
+	Arena thread_arena;
+	ThreadAllocation previous_allocation;
+
+	if(!use_thread_arena(&thread_arena, chunk->result_allocation, &previous_allocation)) {
+		chunk->error = STATIC_ERROR(THREAD_ARENA_ERROR);
+		return NULL;
+	}
+
+	chunk->error = parse_event_lines(&(chunk->state), &(chunk->data_view), chunk->settings,
+	                                 chunk->line_type, false, &(chunk->warnings),
+	                                 &(chunk->errors));
+
+	end_thread_arena(&thread_arena, chunk->result_allocation, previous_allocation);
+
+	return NULL;
+}
+
+static void move_warnings(Warnings* destination, Warnings* source) {
+
+	for(size_t i = 0; i < stbds_arrlenu(source->entries); ++i) {
+		stbds_arrput(destination->entries, source->entries[i]);
+	}
+
+	stbds_arrfree(source->entries);
+}
+
+// every line after the format line can be parsed on its own, so the rest of the section is split
+// into line aligned chunks, the results are merged in source order, so that the result (and the
+// first error) is the same as in the sequential case
+[[nodiscard]] static ErrorStruct
+parse_event_lines_concurrently(EventsParseState* state, StrView data_view, ParseSettings settings,
+                               LineType line_type, size_t line_count, size_t chunk_count,
+                               Warnings* warnings, RecoveredErrors* errors) {
+
+	EventsChunk* chunks = (EventsChunk*)ass_malloc(sizeof(EventsChunk) * chunk_count);
+
+	if(!chunks) {
+		return STATIC_ERROR("allocation error");
+	}
+
+	size_t chunk_size = (data_view.length - data_view.offset) / chunk_count;
+
+	size_t chunk_start = data_view.offset;
+
+	for(size_t i = 0; i < chunk_count; ++i) {
+
+		size_t chunk_end =
+		    i == chunk_count - 1
+		        ? data_view.length
+		        : get_next_line_start(data_view, chunk_start + chunk_size, line_type);
+
+		EventsChunk chunk = {
+			.data_view = { .start = data_view.start, .offset = chunk_start, .length = chunk_end },
+			.settings = settings,
+			.line_type = line_type,
+			.state = { .event_format = state->event_format,
+			           .event_program = state->event_program,
+			           .events = { .entries = STBDS_ARRAY_EMPTY,
+			                       .dialogue_count = 0,
+			                       .comment_count = 0 } },
+			.warnings = { .entries = STBDS_ARRAY_EMPTY },
+			.errors = { .entries = STBDS_ARRAY_EMPTY },
+			.error = NO_ERROR(),
+			.result_allocation = get_thread_allocation(),
+			.thread_started = false,
+		};
+
+		stbds_arrsetcap(chunk.state.events.entries, (line_count / chunk_count) + 1);
+
+		chunks[i] = chunk;
+		chunk_start = chunk_end;
+	}
+
+	// the first chunk is parsed by this thread, if a thread can't be started, the chunk is also
+	// parsed here afterwards
+	for(size_t i = 1; i < chunk_count; ++i) {
+		chunks[i].thread_started =
+		    pthread_create(&(chunks[i].thread), NULL, parse_events_chunk_thread, &(chunks[i])) == 0;
+	}
+
+	parse_events_chunk_thread(&(chunks[0]));
+
+	for(size_t i = 1; i < chunk_count; ++i) {
+		if(chunks[i].thread_started) {
+			pthread_join(chunks[i].thread, NULL);
+		} else {
+			parse_events_chunk_thread(&(chunks[i]));
+		}
+	}
+
+	size_t event_count = 0;
+
+	for(size_t i = 0; i < chunk_count; ++i) {
+		event_count += stbds_arrlenu(chunks[i].state.events.entries);
+	}
+
+	stbds_arrsetcap(state->events.entries, stbds_arrlenu(state->events.entries) + event_count);
+
+	ErrorStruct result = NO_ERROR();
+
+	for(size_t i = 0; i < chunk_count; ++i) {
+		EventsChunk* chunk = &(chunks[i]);
+
+		if(result.message != NULL) {
+			// the sequential parse would never have reached this chunk
+			free_warnings(chunk->warnings);
+			free_recovered_errors(chunk->errors);
+			free_error_struct(chunk->error);
+			stbds_arrfree(chunk->state.events.entries);
+			continue;
+		}
+
+		move_warnings(warnings, &(chunk->warnings));
+
+		// every chunk only knows its own errors, so the limit is applied again here
+		for(size_t j = 0; j < stbds_arrlenu(chunk->errors.entries); ++j) {
+			RecoveredError entry = chunk->errors.entries[j];
+
+			if(result.message != NULL) {
+				free_error_struct(entry.error);
+				continue;
+			}
+
+			if(!recover_from_error(entry.error, entry.section, entry.location, settings, errors)) {
+				result = entry.error;
+			}
+		}
+
+		stbds_arrfree(chunk->errors.entries);
+
+		if(result.message != NULL) {
+			free_error_struct(chunk->error);
+			stbds_arrfree(chunk->state.events.entries);
+			continue;
+		}
+
+		if(chunk->error.message != NULL) {
+			result = chunk->error;
+			stbds_arrfree(chunk->state.events.entries);
+			continue;
+		}
+
+		for(size_t j = 0; j < stbds_arrlenu(chunk->state.events.entries); ++j) {
+			stbds_arrput(state->events.entries, chunk->state.events.entries[j]);
+		}
+
+		state->events.dialogue_count += chunk->state.events.dialogue_count;
+		state->events.comment_count += chunk->state.events.comment_count;
+
+		stbds_arrfree(chunk->state.events.entries);
+	}
+
+	ass_free(chunks);
+
+	return result;
+}
+
+static void set_lazy_field_positions(AssEvents* events,
+                                     const STBDS_ARRAY(AssEventFormat) const format) {
+
+	for(size_t i = 0; i < ASS_LAZY_EVENT_FIELD_COUNT; ++i) {
+		events->lazy_field_positions[i] = SIZE_MAX;
+
+		for(size_t j = 0; j < stbds_arrlenu(format); ++j) {
+			// the last one wins, as in the eager parse
+			if(format[j] == g_lazy_event_formats[i]) {
+				events->lazy_field_positions[i] = j;
+			}
+		}
+	}
+}
+
+[[nodiscard]] static ErrorStruct parse_events(AssEvents* ass_events, StrView* data_view,
+                                              ParseSettings settings, LineType line_type,
+                                              size_t line_count, Warnings* warnings,
+                                              RecoveredErrors* errors) {
+
+	EventsParseState state = {
+		.event_format = STBDS_ARRAY_EMPTY,
+		.event_program = { .instructions = STBDS_ARRAY_EMPTY, .is_canonical = false },
+		.events = { .entries = STBDS_ARRAY_EMPTY, .dialogue_count = 0, .comment_count = 0 },
+	};
+
+	size_t chunk_count = get_event_chunk_count(settings, line_count);
+
+	// same as for the styles, the line count of the section is an upper bound for the event count
+	if(line_count > 0 && chunk_count == 1) {
+		stbds_arrsetcap(state.events.entries, line_count);
+	}
+
+	ErrorStruct error = parse_event_lines(&state, data_view, settings, line_type, chunk_count > 1,
+	                                      warnings, errors);
+
+	if(error.message == NULL && chunk_count > 1 && !str_view_is_eof(*data_view)) {
+		error = parse_event_lines_concurrently(&state, *data_view, settings, line_type, line_count,
+		                                       chunk_count, warnings, errors);
+	}
+
+	if(error.message != NULL) {
+		free_events_parse_state(state);
+		return error;
+	}
+
+	set_lazy_field_positions(&(state.events), state.event_format);
+
+	stbds_arrfree(state.event_format);
+	free_field_program(state.event_program);
+	*ass_events = state.events;
+	return NO_ERROR();
+}
+
+[[nodiscard]] ErrorStruct decode_event_fields(const AssEvents* events, AssEventEntry* entry,
+                                              uint8_t fields) {
+
+	uint8_t pending_fields = entry->pending_fields & fields;
+
+	if(pending_fields == 0) {
+		return NO_ERROR();
+	}
+
+	// missing fields are empty, as in the eager parse
+	ConstStrView values[ASS_LAZY_EVENT_FIELD_COUNT] = {};
+
+	for(size_t i = 0; i < ASS_LAZY_EVENT_FIELD_COUNT; ++i) {
+		values[i] = (ConstStrView){ .start = entry->text.start, .length = 0 };
+	}
+
+	StrView fields_view = { .start = entry->text.start - entry->fields_length,
+		                    .offset = 0,
+		                    .length = entry->fields_length };
+
+	for(size_t position = 0; !str_view_is_eof(fields_view); ++position) {
+
+		ConstStrView value = {};
+		if(!str_view_get_substring_by_char_delimiter(&fields_view, &value, ',', true)) {
+			return STATIC_ERROR("implementation error");
+		}
+
+		for(size_t i = 0; i < ASS_LAZY_EVENT_FIELD_COUNT; ++i) {
+			if(events->lazy_field_positions[i] == position) {
+				values[i] = value;
+			}
+		}
+	}
+
+	for(size_t i = 0; i < ASS_LAZY_EVENT_FIELD_COUNT; ++i) {
+		uint8_t field = (uint8_t)(1 << i);
+
+		if((pending_fields & field) == 0) {
+			continue;
+		}
+
+		ConstStrView value = values[i];
+		ErrorStruct error = NO_ERROR();
+
+		// numbers are never truncated here, so none of these warn
+
+		switch(field) {
+			case AssEventFieldLayer: {
+				entry->layer = parse_str_as_unsigned_number(value, &error, NULL);
+				break;
+			}
+			case AssEventFieldStart: {
+				if(!parse_str_as_fixed_width_time(value, &(entry->start))) {
+					entry->start = parse_str_as_time(value, &error, NULL);
+				}
+				break;
+			}
+			case AssEventFieldEnd: {
+				if(!parse_str_as_fixed_width_time(value, &(entry->end))) {
+					entry->end = parse_str_as_time(value, &error, NULL);
+				}
+				break;
+			}
+			case AssEventFieldMarginL: {
+				entry->margin_l = parse_str_as_margin_value(value, &error, NULL);
+				break;
+			}
+			case AssEventFieldMarginR: {
+				entry->margin_r = parse_str_as_margin_value(value, &error, NULL);
+				break;
+			}
+			case AssEventFieldMarginV: {
+				entry->margin_v = parse_str_as_margin_value(value, &error, NULL);
+				break;
+			}
+			default: {
+				UNREACHABLE();
+			}
+		}
+
+		if(error.message != NULL) {
+			return get_field_parse_error(get_name_for_event_format(g_lazy_event_formats[i]), value,
+			                             error);
+		}
+
+		entry->pending_fields &= (uint8_t)~field;
+	}
+
+	return NO_ERROR();
+}
+
+#undef FREE_AT_END
+
+[[nodiscard]] static ErrorStruct get_section_by_name(AssSectionEntry section, Codepoints data,
+                                                     AssResult* ass_result, ParseSettings settings,
+                                                     LineType line_type, Warnings* warnings,
+                                                     RecoveredErrors* errors) {
+
+	ConstStrView section_name = section.name;
+
+	StrView section_view = get_str_view_for_section(data, section);
+
+	StrView* data_view = &section_view;
+
+	if(str_view_eq_ascii(section_name, "V4+ Styles")) {
+		return parse_styles(&(ass_result->styles), data_view, settings, line_type,
+		                    section.line_count, warnings, errors);
+	}
+
+	if(str_view_eq_ascii(section_name, "V4 Styles")) {
+		return STATIC_ERROR("v4 styles are not supported");
+	}
+
+	if(str_view_eq_ascii(section_name, "Events")) {
+		return parse_events(&(ass_result->events), data_view, settings, line_type,
+		                    section.line_count, warnings, errors);
+	}
+
+	// the section table already knows the range of these, so there is nothing left to skip
+	if(str_view_eq_ascii(section_name, "Fonts")) {
+		return NO_ERROR();
+	}
+
+	if(str_view_eq_ascii(section_name, "Graphics")) {
+		return NO_ERROR();
+	}
+
+	return extra_section(section_name, data_view, &(ass_result->extra_sections), line_type);
+
+	return NO_ERROR();
+}
+
+[[nodiscard]] static uint8_t get_section_mask(ConstStrView section_name) {
+
+	if(str_view_eq_ascii(section_name, "V4+ Styles") ||
+	   str_view_eq_ascii(section_name, "V4 Styles")) {
+		return AssSectionMaskStyles;
+	}
+
+	if(str_view_eq_ascii(section_name, "Events")) {
+		return AssSectionMaskEvents;
+	}
+
+	if(str_view_eq_ascii(section_name, "Fonts")) {
+		return AssSectionMaskFonts;
+	}
+
+	if(str_view_eq_ascii(section_name, "Graphics")) {
+		return AssSectionMaskGraphics;
+	}
+
+	return AssSectionMaskExtra;
+}
+
+[[nodiscard]] static const char* get_section_kind_name(ConstStrView section_name) {
+
+	switch(get_section_mask(section_name)) {
+		case AssSectionMaskStyles: return "styles";
+		case AssSectionMaskEvents: return "events";
+		case AssSectionMaskFonts: return "fonts";
+		case AssSectionMaskGraphics: return "graphics";
+		default: return "extra";
+	}
+}
+
+// returns false, if the section error has to end the parse, the section stays unparsed otherwise
+[[nodiscard]] static bool recover_from_section_error(ErrorStruct error, AssSectionEntry section,
+                                                     ParseSettings settings,
+                                                     RecoveredErrors* errors) {
+	return recover_from_error(error, get_section_kind_name(section.name), section.name, settings,
+	                          errors);
+}
+
+// the first section is the script info section, that is never skipped
+[[nodiscard]] static bool is_section_skipped(AssSectionEntry section, size_t index,
+                                             ParseSettings settings) {
+	return index != 0 && (settings.skipped_sections & get_section_mask(section.name)) != 0;
+}
+
+static void free_extra_sections(ExtraSections sections) {
+
+	size_t hm_length = stbds_shlenu(sections.entries);
+
+	for(size_t i = 0; i < hm_length; ++i) {
+		ExtraSectionHashMapEntry entry = sections.entries[i];
+
+		free_extra_section_entry(entry.value);
+		ass_free(entry.key);
+	}
+
+	stbds_shfree(sections.entries);
+}
+
+static void free_string_pool(AssStringPool pool) {
+	stbds_arrfree(pool.entries);
+	stbds_arrfree(pool.index);
+}
+
+static void free_ass_result(AssResult data) {
+	stbds_arrfree(data.styles.entries);
+	stbds_arrfree(data.styles.name_index);
+	stbds_arrfree(data.events.entries);
+	free_string_pool(data.events.strings);
+
+	free_extra_sections(data.extra_sections);
+}
+
+typedef struct {
+	AssSectionEntry section;
+	bool is_script_info;
+	bool is_skipped;
+	// every job has its own result and warnings, they are merged into the real ones in section
+	// order afterwards
+	AssResult result;
+	Warnings warnings;
+	RecoveredErrors errors;
+	ErrorStruct error;
+} SectionJob;
+
+typedef struct {
+	SectionJob* jobs;
+	size_t job_count;
+	atomic_size_t next_job;
+	Codepoints data;
+	ParseSettings settings;
+	LineType line_type;
+	ThreadAllocation result_allocation;
+} SectionJobQueue;
+
+static void run_section_job(SectionJob* job, Codepoints data, ParseSettings settings,
+                            LineType line_type) {
+
+	if(job->is_skipped) {
+		return;
+	}
+
+	if(job->is_script_info) {
+		StrView section_view = get_str_view_for_section(data, job->section);
+
+		job->error = parse_script_info(&(job->result.script_info), &section_view, settings,
+		                               line_type, &(job->warnings));
+		return;
+	}
+
+	job->error = get_section_by_name(job->section, data, &(job->result), settings, line_type,
+	                                 &(job->warnings), &(job->errors));
+}
+
+static void* parse_section_jobs_thread(void* arg) {
+
+	SectionJobQueue* queue = (SectionJobQueue*)arg;
+
+	Arena thread_arena;
+	ThreadAllocation previous_allocation;
+
+	// the jobs, that this thread takes, fail, so that none of them is silently left out
+	bool has_arena =
+	    use_thread_arena(&thread_arena, queue->result_allocation, &previous_allocation);
+
+	while(true) {
+		size_t index = atomic_fetch_add(&(queue->next_job), 1);
+
+		if(index >= queue->job_count) {
+			break;
+		}
+
+		if(!has_arena) {
+			queue->jobs[index].error = STATIC_ERROR(THREAD_ARENA_ERROR);
+			continue;
+		}
+
+		run_section_job(&(queue->jobs[index]), queue->data, queue->settings, queue->line_type);
+	}
+
+	if(!has_arena) {
+		return NULL;
+	}
+
+	end_thread_arena(&thread_arena, queue->result_allocation, previous_allocation);
+
+	return NULL;
+}
+
+static void merge_section_result(AssResult* ass_result, SectionJob* job) {
+
+	if(job->is_script_info) {
+		ass_result->script_info = job->result.script_info;
+		return;
+	}
+
+	// a later section with the same name replaces the earlier one, as in the sequential case
+	if(str_view_eq_ascii(job->section.name, "V4+ Styles")) {
+		stbds_arrfree(ass_result->styles.entries);
+		stbds_arrfree(ass_result->styles.name_index);
+		ass_result->styles = job->result.styles;
+		return;
+	}
+
+	if(str_view_eq_ascii(job->section.name, "Events")) {
+		stbds_arrfree(ass_result->events.entries);
+		free_string_pool(ass_result->events.strings);
+		ass_result->events = job->result.events;
+		return;
+	}
+
+	ExtraSectionHashMapEntry* entries = job->result.extra_sections.entries;
+
+	for(size_t i = 0; i < stbds_shlenu(entries); ++i) {
+		ptrdiff_t previous_index = stbds_shgeti(ass_result->extra_sections.entries, entries[i].key);
+
+		if(previous_index < 0) {
+			stbds_shputs(ass_result->extra_sections.entries, entries[i]);
+			continue;
+		}
+
+		// the map keeps its own key for an existing entry, so only the value is replaced
+		ExtraSectionHashMapEntry* previous = &(ass_result->extra_sections.entries[previous_index]);
+
+		free_extra_section_entry(previous->value);
+		previous->value = entries[i].value;
+
+		ass_free(entries[i].key);
+	}
+
+	stbds_shfree(entries);
+}
+
+// every section only depends on its own line range, so with the section table present, all
+// sections can be parsed at the same time, the results are merged in section order, so that the
+// result (and the first error) is the same as in the sequential case
+[[nodiscard]] static ErrorStruct parse_sections_concurrently(AssSections sections,
+                                                             Codepoints data, AssResult* ass_result,
+                                                             ParseSettings settings,
+                                                             LineType line_type,
+                                                             Warnings* warnings,
+                                                             RecoveredErrors* errors) {
+
+	size_t job_count = stbds_arrlenu(sections.entries);
+
+	SectionJob* jobs = (SectionJob*)ass_malloc(sizeof(SectionJob) * job_count);
+
+	if(!jobs) {
+		return STATIC_ERROR("allocation error");
+	}
+
+	for(size_t i = 0; i < job_count; ++i) {
+		jobs[i] = (SectionJob){
+			.section = sections.entries[i],
+			.is_script_info = i == 0,
+			.is_skipped = is_section_skipped(sections.entries[i], i, settings),
+			.result = { .extra_sections = (ExtraSections){ .entries = STBDS_HASH_MAP_EMPTY } },
+			.warnings = { .entries = STBDS_ARRAY_EMPTY },
+			.errors = { .entries = STBDS_ARRAY_EMPTY },
+			.error = NO_ERROR(),
+		};
+	}
+
+	SectionJobQueue queue = {
+		.jobs = jobs,
+		.job_count = job_count,
+		.data = data,
+		.settings = settings,
+		.line_type = line_type,
+		.result_allocation = get_thread_allocation(),
+	};
+
+	atomic_init(&(queue.next_job), 0);
+
+	size_t worker_count = job_count < settings.thread_count ? job_count : settings.thread_count;
+
+	// the events section gets the threads, that are not used for the sections, so that the total
+	// amount of threads stays within the thread count
+	queue.settings.thread_count = settings.thread_count - worker_count + 1;
+
+	// this thread is one of the workers, so one thread less has to be started
+	pthread_t* threads = (pthread_t*)ass_malloc(sizeof(pthread_t) * worker_count);
+
+	size_t started_threads = 0;
+
+	if(threads) {
+		for(size_t i = 1; i < worker_count; ++i) {
+			if(pthread_create(&(threads[started_threads]), NULL, parse_section_jobs_thread,
+			                  &queue) != 0) {
+				break;
+			}
+			++started_threads;
+		}
+	}
+
+	parse_section_jobs_thread(&queue);
+
+	for(size_t i = 0; i < started_threads; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+
+	ass_free(threads);
+
+	ErrorStruct result = NO_ERROR();
+
+	for(size_t i = 0; i < job_count; ++i) {
+		SectionJob* job = &(jobs[i]);
+
+		if(result.message != NULL) {
+			// the sequential parse would never have reached this section
+			free_warnings(job->warnings);
+			free_recovered_errors(job->errors);
+			free_error_struct(job->error);
+			free_ass_result(job->result);
+			continue;
+		}
+
+		move_warnings(warnings, &(job->warnings));
+
+		// same as for the event chunks, the limit only holds for all jobs together
+		for(size_t j = 0; j < stbds_arrlenu(job->errors.entries); ++j) {
+			RecoveredError entry = job->errors.entries[j];
+
+			if(result.message != NULL) {
+				free_error_struct(entry.error);
+				continue;
+			}
+
+			if(!recover_from_error(entry.error, entry.section, entry.location, settings, errors)) {
+				result = entry.error;
+			}
+		}
+
+		stbds_arrfree(job->errors.entries);
+
+		if(result.message != NULL) {
+			free_error_struct(job->error);
+			free_ass_result(job->result);
+			continue;
+		}
+
+		if(job->error.message != NULL) {
+			if(job->is_script_info ||
+			   !recover_from_section_error(job->error, job->section, settings, errors)) {
+				result = job->error;
+			}
+
+			free_ass_result(job->result);
+			continue;
+		}
+
+		if(job->is_skipped) {
+			continue;
+		}
+
+		merge_section_result(ass_result, job);
+		sections.entries[i].parsed = true;
+	}
+
+	ass_free(jobs);
+
+	return result;
+}
+
+#define FREE_AT_END() \
+	do { \
+	} while(false)
+
+#define RETURN_ERROR(err) \
+	do { \
+		FREE_AT_END(); \
+		result->is_error = true; \
+		result->data.error = err; \
+		return result; \
+	} while(false)
+
+// the script info section ends before the first line, that starts with '[', all these characters
+// are single bytes in UTF-8, so the rest of the file doesn't need to be decoded to find it
+[[nodiscard]] static size_t get_script_info_byte_length(SizedPtr data) {
+
+	const uint8_t* bytes = (const uint8_t*)data.data;
+
+	// the first line is the header of the script info section itself
+	for(size_t i = 1; i < data.len; ++i) {
+		if(bytes[i] == '[' && (bytes[i - 1] == '\n' || bytes[i - 1] == '\r')) {
+			return i;
+		}
+	}
+
+	return data.len;
+}
+
+[[nodiscard]] static uint32_t get_str_hash(FinalStr name) {
+
+	// FNV-1a over the codepoints
+	uint32_t hash = 2166136261U;
+
+	for(size_t i = 0; i < name.length; ++i) {
+		hash = (hash ^ (uint32_t)name.start[i]) * 16777619U;
+	}
+
+	return hash;
+}
+
+// returns the slot of the name or the empty slot, where it would be inserted
+[[nodiscard]] static size_t find_style_name_slot(const AssStyles* styles, FinalStr name) {
+
+	size_t mask = stbds_arrlenu(styles->name_index) - 1;
+	size_t slot = get_str_hash(name) & mask;
+
+	while(styles->name_index[slot] != 0 &&
+	      !str_view_eq_str_view(styles->entries[styles->name_index[slot] - 1].name, name)) {
+		slot = (slot + 1) & mask;
+	}
+
+	return slot;
+}
+
+[[nodiscard]] static uint32_t find_style_index(const AssStyles* styles, FinalStr name) {
+
+	if(stbds_arrlenu(styles->name_index) == 0) {
+		return ASS_STYLE_INDEX_UNKNOWN;
+	}
+
+	uint32_t value = styles->name_index[find_style_name_slot(styles, name)];
+
+	return value == 0 ? ASS_STYLE_INDEX_UNKNOWN : value - 1;
+}
+
+// the table has at least twice as many slots as there are styles, so that probing stays short
+static void build_style_name_index(AssStyles* styles) {
+
+	stbds_arrfree(styles->name_index);
+
+	size_t style_count = stbds_arrlenu(styles->entries);
+
+	if(style_count == 0) {
+		return;
+	}
+
+	size_t capacity = 4;
+
+	while(capacity < style_count * 2) {
+		capacity <<= 1;
+	}
+
+	stbds_arrsetlen(styles->name_index, capacity);
+	memset(styles->name_index, 0, capacity * sizeof(uint32_t));
+
+	// a later style with the same name replaces the earlier one
+	for(size_t i = 0; i < style_count; ++i) {
+		size_t slot = find_style_name_slot(styles, styles->entries[i].name);
+		styles->name_index[slot] = (uint32_t)(i + 1);
+	}
+}
+
+[[nodiscard]] const AssStyleEntry* ass_result_find_style(const AssResult* result, FinalStr name) {
+
+	uint32_t index = find_style_index(&(result->styles), name);
+
+	if(index == ASS_STYLE_INDEX_UNKNOWN) {
+		return NULL;
+	}
+
+	return &(result->styles.entries[index]);
+}
+
+[[nodiscard]] static bool are_styles_parsed(AssSections sections) {
+
+	for(size_t i = 0; i < stbds_arrlenu(sections.entries); ++i) {
+		if(get_section_mask(sections.entries[i].name) == AssSectionMaskStyles &&
+		   !sections.entries[i].parsed) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void remove_unknown_style_warnings(Warnings* warnings) {
+
+	size_t kept = 0;
+
+	for(size_t i = 0; i < stbds_arrlenu(warnings->entries); ++i) {
+		if(warnings->entries[i].type != WarningTypeUnknownStyle) {
+			warnings->entries[kept] = warnings->entries[i];
+			++kept;
+		}
+	}
+
+	stbds_arrsetlen(warnings->entries, kept);
+}
+
+// returns the slot of the string or the empty slot, where it would be inserted
+[[nodiscard]] static size_t find_string_pool_slot(const AssStringPool* pool, FinalStr str,
+                                                  uint32_t hash) {
+
+	size_t mask = stbds_arrlenu(pool->index) - 1;
+	size_t slot = hash & mask;
+
+	while(pool->index[slot] != 0 &&
+	      !str_view_eq_str_view(pool->entries[pool->index[slot] - 1], str)) {
+		slot = (slot + 1) & mask;
+	}
+
+	return slot;
+}
+
+// the table is kept at most half full
+static void grow_string_pool_index(AssStringPool* pool) {
+
+	size_t capacity = stbds_arrlenu(pool->index) == 0 ? 64 : stbds_arrlenu(pool->index) * 2;
+
+	stbds_arrfree(pool->index);
+	stbds_arrsetlen(pool->index, capacity);
+	memset(pool->index, 0, capacity * sizeof(uint32_t));
+
+	for(size_t i = 0; i < stbds_arrlenu(pool->entries); ++i) {
+		FinalStr str = pool->entries[i];
+		size_t slot = find_string_pool_slot(pool, str, get_str_hash(str));
+		pool->index[slot] = (uint32_t)(i + 1);
+	}
+}
+
+[[nodiscard]] static uint32_t intern_string(AssStringPool* pool, FinalStr str) {
+
+	if((stbds_arrlenu(pool->entries) + 1) * 2 > stbds_arrlenu(pool->index)) {
+		grow_string_pool_index(pool);
+	}
+
+	size_t slot = find_string_pool_slot(pool, str, get_str_hash(str));
+
+	if(pool->index[slot] == 0) {
+		stbds_arrput(pool->entries, str);
+		pool->index[slot] = (uint32_t)stbds_arrlenu(pool->entries);
+	}
+
+	return pool->index[slot] - 1;
+}
+
+// the pool is built again from scratch, so that strings of removed events don't stay in it
+static void intern_event_strings(AssEvents* events) {
+
+	free_string_pool(events->strings);
+	events->strings = (AssStringPool){ .entries = STBDS_ARRAY_EMPTY, .index = STBDS_ARRAY_EMPTY };
+
+	for(size_t i = 0; i < stbds_arrlenu(events->entries); ++i) {
+		AssEventEntry* entry = &(events->entries[i]);
+
+		entry->name_id = intern_string(&(events->strings), entry->name);
+		entry->effect_id = intern_string(&(events->strings), entry->effect);
+		entry->text_id = intern_string(&(events->strings), entry->text);
+	}
+}
+
+// builds the style name index and resolves the style of every event, the unknown style warnings
+// are built again too, so that they are never duplicated, while the styles are not parsed, no
+// style is known and nothing is warned about
+static void resolve_event_styles(AssParseResult* result) {
+
+	AssResult* ass_result = &(result->data.ok);
+	AssEvents* events = &(ass_result->events);
+
+	bool styles_parsed = are_styles_parsed(result->sections);
+	bool warn_unknown_styles = styles_parsed && result->settings.warn_unknown_styles;
+
+	remove_unknown_style_warnings(&(result->warnings));
+
+	if(styles_parsed) {
+		build_style_name_index(&(ass_result->styles));
+	} else {
+		stbds_arrfree(ass_result->styles.name_index);
+	}
+
+	for(size_t i = 0; i < stbds_arrlenu(events->entries); ++i) {
+		AssEventEntry* entry = &(events->entries[i]);
+
+		// consecutive events mostly share their style
+		if(i > 0 && str_view_eq_str_view(events->entries[i - 1].style, entry->style)) {
+			entry->style_index = events->entries[i - 1].style_index;
+		} else {
+			entry->style_index = find_style_index(&(ass_result->styles), entry->style);
+		}
+
+		if(entry->style_index == ASS_STYLE_INDEX_UNKNOWN && warn_unknown_styles) {
+			WarningEntry warning = { .type = WarningTypeUnknownStyle,
+				                     .data = { .unknown_style = { .style = entry->style } } };
+
+			stbds_arrput(result->warnings.entries, warning);
+		}
+	}
+}
+
+// everything, that is derived from the events, is built again after every change of the result
+static void update_event_indices(AssParseResult* result) {
+
+	resolve_event_styles(result);
+
+	if(result->settings.intern_event_strings) {
+		intern_event_strings(&(result->data.ok.events));
+	}
+}
+
+[[nodiscard]] static AssParseResult* alloc_parse_result(ParseSettings settings) {
+
+	AssParseResult* result =
+	    (AssParseResult*)allocator_malloc(settings.allocator, sizeof(AssParseResult));
+
+	if(!result) {
+		return NULL;
+	}
+
+	result->warnings = (Warnings){ .entries = STBDS_ARRAY_EMPTY };
+	result->recovered_errors = (RecoveredErrors){ .entries = STBDS_ARRAY_EMPTY };
+	result->allocated_codepoints = (Codepoints){ .data = NULL, .size = 0 };
+	result->sections = (AssSections){ .entries = STBDS_ARRAY_EMPTY };
+	result->settings = settings;
+	result->file_type = FileTypeUnknown;
+	result->is_compacted = false;
+	result->raw_source = (RawSource){ .is_present = false, .data = { .data = NULL, .len = 0 } };
+
+	if(!init_arena(&(result->arena), settings.allocator)) {
+		allocator_free(settings.allocator, result);
+		return NULL;
+	}
+
+	return result;
+}
+
+// everything, that is allocated while the result is changed, is owned by its arena
+static ThreadAllocation use_result_allocation(AssParseResult* result) {
+	return set_thread_allocation(
+	    (ThreadAllocation){ .allocator = result->settings.allocator, .arena = &(result->arena) });
+}
+
+#define UNRECOGNIZED_FILE_TYPE_ERROR "unrecognized file type, no BOM present"
+
+static void add_unrecognized_file_type_warning(Warnings* warnings) {
+
+	WarningEntry warning = { .type = WarningTypeUnrecognizedFileType };
+
+	stbds_arrput(warnings->entries, warning);
+}
+
+// parses the already decoded data, the data is owned by the result afterwards, even on error
+[[nodiscard]] static AssParseResult* parse_ass_codepoints(AssParseResult* result,
+                                                         Codepoints final_data, FileType file_type,
+                                                         bool parse_all_sections) {
+
+	ParseSettings settings = result->settings;
+
+	// NOTE: the bom byte is always just one codepoint
+	size_t bom_size = file_type == FileTypeUnknown ? 0 : 1;
+
+	result->file_type = file_type;
+
+	if(final_data.data == NULL && final_data.size == 0) {
+		// text can still be inserted into an empty source
+		result->raw_source.is_present = true;
+		RETURN_ERROR(STATIC_ERROR("file conversion resulted in empty UTF-8 string"));
+	}
+
+	result->allocated_codepoints = final_data;
+
+	StrView data_view = str_view_from_data(final_data);
+
+	if(bom_size > 0) {
+		if(!str_view_advance(&data_view, bom_size)) {
+			RETURN_ERROR(STATIC_ERROR("couldn't skip bom bytes"));
+		}
+	}
+
+	// get line type
+	char* line_type_error = NULL;
+
+	ConstStrView line_type_view = get_const_str_view_from_str_view(data_view);
+
+	LineType line_type = get_line_type(line_type_view, &line_type_error);
+
+	if(line_type_error != NULL) {
+		RETURN_ERROR(DYNAMIC_ERROR(line_type_error));
+	}
+
+	// parse script info
+
+	{
+		StrView header_view = data_view;
+
+		if(!str_view_expect_ascii(&header_view, "[Script Info]")) {
+			RETURN_ERROR(STATIC_ERROR("first line must be the script info section"));
+		}
+
+		if(!str_view_expect_newline(&header_view, line_type)) {
+			RETURN_ERROR(STATIC_ERROR("expected newline"));
+		}
+	}
+
+	ErrorStruct section_table_result =
+	    build_section_table(data_view, line_type, settings.script_info_only, &(result->sections));
+
+	if(section_table_result.message != NULL) {
+		RETURN_ERROR(section_table_result);
+	}
+
+	AssResult ass_result = { .extra_sections = (ExtraSections){ .entries = STBDS_HASH_MAP_EMPTY },
+		                     .file_props = { .file_type = file_type, .line_type = line_type } };
+
+#undef FREE_AT_END
+#define FREE_AT_END() \
+	do { \
+		free_ass_result(ass_result); \
+	} while(false)
+
+	if(parse_all_sections && settings.thread_count > 1 &&
+	   stbds_arrlenu(result->sections.entries) > 1) {
+		ErrorStruct sections_parse_result =
+		    parse_sections_concurrently(result->sections, final_data, &ass_result, settings,
+		                                line_type, &(result->warnings),
+		                                &(result->recovered_errors));
+
+		if(sections_parse_result.message != NULL) {
+			RETURN_ERROR(sections_parse_result);
+		}
+
+		result->is_error = false;
+		result->data.ok = ass_result;
+		return result;
+	}
+
+	// the first section is always the script info section, as checked above
+	AssSectionEntry* script_info_section = &(result->sections.entries[0]);
+
+	StrView script_info_view = get_str_view_for_section(final_data, *script_info_section);
+
+	ErrorStruct script_info_parse_result = parse_script_info(
+	    &(ass_result.script_info), &script_info_view, settings, line_type, &(result->warnings));
+
+	if(script_info_parse_result.message != NULL) {
+		RETURN_ERROR(script_info_parse_result);
+	}
+
+	script_info_section->parsed = true;
+
+	if(parse_all_sections) {
+		for(size_t i = 1; i < stbds_arrlenu(result->sections.entries); ++i) {
+			AssSectionEntry* section = &(result->sections.entries[i]);
+
+			if(is_section_skipped(*section, i, settings)) {
+				continue;
+			}
+
+			ErrorStruct section_parse_result =
+			    get_section_by_name(*section, final_data, &ass_result, settings, line_type,
+			                        &(result->warnings), &(result->recovered_errors));
+
+			if(section_parse_result.message != NULL) {
+				if(!recover_from_section_error(section_parse_result, *section, settings,
+				                               &(result->recovered_errors))) {
+					RETURN_ERROR(section_parse_result);
+				}
+
+				continue;
+			}
+
+			section->parsed = true;
+		}
+	}
+
+	result->is_error = false;
+	result->data.ok = ass_result;
+	return result;
+}
+
+#undef FREE_AT_END
+#define FREE_AT_END() \
+	do { \
+	} while(false)
+
+// the copy is allocated like the codepoints, as the data of the source may not be owned
+[[nodiscard]] static RawSource copy_raw_source(SizedPtr data) {
+
+	void* copy = ass_malloc(data.len);
+
+	if(!copy) {
+		return (RawSource){ .is_present = false, .data = { .data = NULL, .len = 0 } };
+	}
+
+	memcpy(copy, data.data, data.len);
+
+	return (RawSource){ .is_present = true, .data = { .data = copy, .len = data.len } };
+}
+
+[[nodiscard]] static AssParseResult* parse_ass_source(AssParseResult* result, AssSource source,
+                                                     AssParserContext* context,
+                                                     bool parse_all_sections) {
+
+	ParseSettings settings = result->settings;
+
+	SizedPtr data = get_data_from_source(source, context);
+
+	if(is_ptr_error(data)) {
+		RETURN_ERROR(STATIC_ERROR(ptr_get_error(data)));
+	}
+
+	FileType file_type = determine_file_type(data);
+
+	result->file_type = file_type;
+
+	if(settings.script_info_only && (file_type == FileTypeUtf8 || file_type == FileTypeUnknown)) {
+		data.len = get_script_info_byte_length(data);
+	}
+
+	// without a context, the conversion state is only used for this source
+	Utf8Converter local_converter = get_utf8_converter(get_thread_allocation().allocator);
+	Utf8Converter* converter = context != NULL ? &(context->converter) : &local_converter;
+
+	CodepointsResult codepoints_result = { .has_error = true,
+		                                   .data = { .error = "implementation error" } };
+
+	switch(file_type) {
+		case FileTypeUnknown: {
+			if(!settings.strict_settings.allow_unrecognized_file_encoding) {
+				if(is_source_data_owned(source, context)) {
+					free_sized_ptr(data);
+				}
+				RETURN_ERROR(STATIC_ERROR(UNRECOGNIZED_FILE_TYPE_ERROR));
+			}
+
+			add_unrecognized_file_type_warning(&(result->warnings));
+			codepoints_result = get_codepoints_from_utf8(data);
+			break;
+		}
+		case FileTypeUtf8: {
+			codepoints_result = get_codepoints_from_utf8(data);
+			break;
+		}
+		case FileTypeUtf16BE: {
+			codepoints_result = get_codepoints_from_utf16_with_converter(data, true, converter);
+			break;
+		}
+		case FileTypeUtf16LE: {
+			codepoints_result = get_codepoints_from_utf16_with_converter(data, false, converter);
+			break;
+		}
+		case FileTypeUtf32BE: {
+			codepoints_result = get_codepoints_from_utf32_with_converter(data, true, converter);
+			break;
+		}
+		case FileTypeUtf32LE: {
+			codepoints_result = get_codepoints_from_utf32_with_converter(data, false, converter);
+			break;
+		}
+
+		default: {
+			if(is_source_data_owned(source, context)) {
+				free_sized_ptr(data);
+			}
+			free_utf8_converter(&local_converter);
+
+			char* result_buffer = NULL;
+			FORMAT_STRING_DEFAULT(&result_buffer,
+			                      "only UTF-8 encoded files supported atm, but got: %s",
+			                      get_file_type_name(file_type));
+
+			RETURN_ERROR(DYNAMIC_ERROR(result_buffer));
+		}
+	}
+
+	// an editor can still fix the bytes with parse_ass_incremental
+	if(codepoints_result.has_error && !settings.script_info_only) {
+		result->raw_source = copy_raw_source(data);
+	}
+
+	if(is_source_data_owned(source, context)) {
+		free_sized_ptr(data);
+	}
+
+	free_utf8_converter(&local_converter);
+
+	if(codepoints_result.has_error) {
+		RETURN_ERROR(STATIC_ERROR(codepoints_result.data.error));
+	}
+
+	return parse_ass_codepoints(result, codepoints_result.data.result, file_type,
+	                            parse_all_sections);
+}
+
+[[nodiscard]] static AssParseResult* parse_ass_impl(AssSource source, ParseSettings settings,
+                                                   AssParserContext* context,
+                                                   bool parse_all_sections) {
+
+	AssParseResult* result = alloc_parse_result(settings);
+
+	if(!result) {
+		return NULL;
+	}
+
+	ThreadAllocation previous_allocation = use_result_allocation(result);
+
+	result = parse_ass_source(result, source, context, parse_all_sections);
+
+	if(!result->is_error) {
+		update_event_indices(result);
+	}
+
+	set_thread_allocation(previous_allocation);
+
+	return result;
+}
+
+[[nodiscard]] AssParseResult* parse_ass(AssSource source, ParseSettings settings) {
+	return parse_ass_impl(source, settings, NULL, true);
+}
+
+[[nodiscard]] AssParseResult* parse_ass_with_context(AssParserContext* context, AssSource source,
+                                                     ParseSettings settings) {
+	return parse_ass_impl(source, settings, context, true);
+}
+
+[[nodiscard]] AssParseResult* parse_ass_section_table(AssSource source, ParseSettings settings) {
+	return parse_ass_impl(source, settings, NULL, false);
+}
+
+[[nodiscard]] AssSections parse_result_get_sections(AssParseResult* result) {
+	return result->sections;
+}
+
+[[nodiscard]] static ErrorStruct parse_sections_with_name(AssParseResult* result,
+                                                          const char* section_name,
+                                                          bool* found_section) {
+
+	for(size_t i = 0; i < stbds_arrlenu(result->sections.entries); ++i) {
+		AssSectionEntry* section = &(result->sections.entries[i]);
+
+		char* name = alloc_normalized_string(section->name);
+
+		if(!name) {
+			return STATIC_ERROR("allocation error");
+		}
+
+		bool is_same_name = strcmp(name, section_name) == 0;
+
+		ass_free(name);
+
+		if(!is_same_name) {
+			continue;
+		}
+
+		*found_section = true;
+
+		if(section->parsed) {
+			continue;
+		}
+
+		ErrorStruct section_parse_result = get_section_by_name(
+		    *section, result->allocated_codepoints, &(result->data.ok), result->settings,
+		    result->data.ok.file_props.line_type, &(result->warnings),
+		    &(result->recovered_errors));
+
+		if(section_parse_result.message != NULL) {
+			return section_parse_result;
+		}
+
+		section->parsed = true;
+	}
+
+	return NO_ERROR();
+}
+
+[[nodiscard]] ErrorStruct parse_result_parse_section(AssParseResult* result,
+                                                     const char* section_name) {
+
+	if(result->is_error) {
+		return STATIC_ERROR("can't parse a section of a result, that is an error");
+	}
+
+	if(result->is_compacted) {
+		return STATIC_ERROR("can't parse a section of a compacted result");
+	}
+
+	bool found_section = false;
+
+	ThreadAllocation previous_allocation = use_result_allocation(result);
+
+	ErrorStruct section_parse_result =
+	    parse_sections_with_name(result, section_name, &found_section);
+
+	if(section_parse_result.message == NULL) {
+		update_event_indices(result);
+	}
+
+	set_thread_allocation(previous_allocation);
+
+	if(section_parse_result.message != NULL) {
+		return section_parse_result;
+	}
+
+	if(!found_section) {
+		char* result_buffer = NULL;
+		FORMAT_STRING_DEFAULT(&result_buffer, "no section with the name '%s' present",
+		                      section_name);
+
+		return DYNAMIC_ERROR(result_buffer);
+	}
+
+	return NO_ERROR();
+}
+
+// the budget, the cancellation and the progress are checked after every block of that many lines
+#define PARSE_STEP_BLOCK_LINES 256
+
+typedef enum : uint8_t {
+	ParseJobSectionNone,
+	ParseJobSectionStyles,
+	ParseJobSectionEvents,
+} ParseJobSection;
+
+struct AssParseJobImpl {
+	AssParseResult* result;
+	size_t next_section;
+	// the styles and events sections are parsed in blocks of lines, all other sections at once
+	ParseJobSection current_type;
+	size_t current_section;
+	StrView current_view;
+	StylesParseState styles_state;
+	EventsParseState events_state;
+	AssParseProgress progress;
+	bool is_done;
+	atomic_bool is_cancelled;
+};
+
+[[nodiscard]] static uint64_t get_current_microseconds(void) {
+
+	struct timespec now = {};
+
+	if(timespec_get(&now, TIME_UTC) != TIME_UTC) {
+		return 0;
+	}
+
+	return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+[[nodiscard]] AssParseJob* parse_ass_start(AssSource source, ParseSettings settings) {
+
+	AssParseJob* job = (AssParseJob*)allocator_malloc(settings.allocator, sizeof(AssParseJob));
+
+	if(!job) {
+		return NULL;
+	}
+
+	AssParseResult* result = parse_ass_impl(source, settings, NULL, false);
+
+	if(!result) {
+		allocator_free(settings.allocator, job);
+		return NULL;
+	}
+
+	job->result = result;
+	job->next_section = 1;
+	job->current_type = ParseJobSectionNone;
+	job->current_section = 0;
+	job->current_view = (StrView){ .start = NULL, .offset = 0, .length = 0 };
+	job->progress = (AssParseProgress){ .parsed_lines = 0,
+		                                .total_lines = 0,
+		                                .parsed_sections = 0,
+		                                .section_count = 0 };
+	job->is_done = result->is_error;
+	atomic_init(&(job->is_cancelled), false);
+
+	if(result->is_error) {
+		return job;
+	}
+
+	AssSections sections = result->sections;
+
+	for(size_t i = 0; i < stbds_arrlenu(sections.entries); ++i) {
+		if(is_section_skipped(sections.entries[i], i, settings)) {
+			continue;
+		}
+
+		job->progress.section_count++;
+
+		if(sections.entries[i].parsed) {
+			job->progress.parsed_sections++;
+		} else {
+			job->progress.total_lines += sections.entries[i].line_count;
+		}
+	}
+
+	return job;
+}
+
+static void free_parse_job_state(AssParseJob* job) {
+
+	if(job->current_type == ParseJobSectionStyles) {
+		free_styles_parse_state(job->styles_state);
+	} else if(job->current_type == ParseJobSectionEvents) {
+		free_events_parse_state(job->events_state);
+	}
+
+	job->current_type = ParseJobSectionNone;
+}
+
+static void fail_parse_job(AssParseJob* job, ErrorStruct error) {
+
+	free_parse_job_state(job);
+
+	free_ass_result(job->result->data.ok);
+	job->result->is_error = true;
+	job->result->data.error = error;
+
+	job->is_done = true;
+}
+
+// returns the end of the block of at most max_lines lines, that starts at the offset of the view
+[[nodiscard]] static size_t get_line_block_end(StrView view, LineType line_type, size_t max_lines,
+                                               size_t* line_count) {
+
+	size_t position = view.offset;
+	size_t lines = 0;
+
+	while(lines < max_lines && position < view.length) {
+		position = get_next_line_start(view, position, line_type);
+		++lines;
+	}
+
+	*line_count = lines;
+	return position;
+}
+
+[[nodiscard]] static ErrorStruct begin_parse_job_section(AssParseJob* job, size_t* parsed_lines) {
+
+	AssParseResult* result = job->result;
+	AssSections sections = result->sections;
+
+	while(job->next_section < stbds_arrlenu(sections.entries) &&
+	      is_section_skipped(sections.entries[job->next_section], job->next_section,
+	                         result->settings)) {
+		job->next_section++;
+	}
+
+	if(job->next_section >= stbds_arrlenu(sections.entries)) {
+		job->is_done = true;
+		return NO_ERROR();
+	}
+
+	size_t index = job->next_section;
+	job->next_section++;
+
+	AssSectionEntry* section = &(sections.entries[index]);
+
+	if(section->parsed) {
+		return NO_ERROR();
+	}
+
+	if(str_view_eq_ascii(section->name, "V4+ Styles")) {
+		job->styles_state = (StylesParseState){
+			.style_format = STBDS_ARRAY_EMPTY,
+			.style_program = { .instructions = STBDS_ARRAY_EMPTY },
+			.styles = { .entries = STBDS_ARRAY_EMPTY },
+		};
+		job->current_type = ParseJobSectionStyles;
+	} else if(str_view_eq_ascii(section->name, "Events")) {
+		job->events_state = (EventsParseState){
+			.event_format = STBDS_ARRAY_EMPTY,
+			.event_program = { .instructions = STBDS_ARRAY_EMPTY, .is_canonical = false },
+			.events = { .entries = STBDS_ARRAY_EMPTY, .dialogue_count = 0, .comment_count = 0 },
+		};
+		job->current_type = ParseJobSectionEvents;
+	}
+
+	if(job->current_type != ParseJobSectionNone) {
+		job->current_section = index;
+		job->current_view = get_str_view_for_section(result->allocated_codepoints, *section);
+		return NO_ERROR();
+	}
+
+	*parsed_lines = section->line_count;
+
+	ErrorStruct error = get_section_by_name(
+	    *section, result->allocated_codepoints, &(result->data.ok), result->settings,
+	    result->data.ok.file_props.line_type, &(result->warnings), &(result->recovered_errors));
+
+	if(error.message != NULL) {
+		if(!recover_from_section_error(error, *section, result->settings,
+		                               &(result->recovered_errors))) {
+			return error;
+		}
+	} else {
+		section->parsed = true;
+	}
+
+	job->progress.parsed_sections++;
+	return NO_ERROR();
+}
+
+static void end_parse_job_section(AssParseJob* job) {
+
+	AssSectionEntry* section = &(job->result->sections.entries[job->current_section]);
+
+	SectionJob section_job = {
+		.section = *section,
+		.result = { .extra_sections = (ExtraSections){ .entries = STBDS_HASH_MAP_EMPTY } },
+	};
+
+	if(job->current_type == ParseJobSectionStyles) {
+		StylesParseState state = job->styles_state;
+
+		stbds_arrfree(state.style_format);
+		free_field_program(state.style_program);
+		section_job.result.styles = state.styles;
+	} else {
+		EventsParseState state = job->events_state;
+
+		set_lazy_field_positions(&(state.events), state.event_format);
+
+		stbds_arrfree(state.event_format);
+		free_field_program(state.event_program);
+		section_job.result.events = state.events;
+	}
+
+	merge_section_result(&(job->result->data.ok), &section_job);
+
+	section->parsed = true;
+	job->current_type = ParseJobSectionNone;
+	job->progress.parsed_sections++;
+}
+
+[[nodiscard]] static ErrorStruct parse_job_block(AssParseJob* job, size_t max_lines,
+                                                 size_t* parsed_lines) {
+
+	*parsed_lines = 0;
+
+	if(job->current_type == ParseJobSectionNone) {
+		return begin_parse_job_section(job, parsed_lines);
+	}
+
+	AssParseResult* result = job->result;
+	LineType line_type = result->data.ok.file_props.line_type;
+	RecoveredErrors* errors = &(result->recovered_errors);
+
+	StrView block_view = job->current_view;
+	block_view.length = get_line_block_end(job->current_view, line_type, max_lines, parsed_lines);
+
+	size_t error_count = stbds_arrlenu(errors->entries);
+
+	ErrorStruct error = NO_ERROR();
+	bool has_format = false;
+
+	if(job->current_type == ParseJobSectionStyles) {
+		error = parse_style_lines(&(job->styles_state), &block_view, result->settings, line_type,
+		                          &(result->warnings), errors);
+		has_format = stbds_arrlenu(job->styles_state.style_format) != 0;
+	} else {
+		error = parse_event_lines(&(job->events_state), &block_view, result->settings, line_type,
+		                          false, &(result->warnings), errors);
+		has_format = stbds_arrlenu(job->events_state.event_format) != 0;
+	}
+
+	if(error.message != NULL) {
+		return error;
+	}
+
+	job->current_view.offset = block_view.length;
+
+	// the line parsers skip the rest of the section, if an error left it without a format
+	if(stbds_arrlenu(errors->entries) > error_count && !has_format) {
+		size_t skipped_lines = 0;
+		job->current_view.offset =
+		    get_line_block_end(job->current_view, line_type, SIZE_MAX, &skipped_lines);
+		*parsed_lines += skipped_lines;
+	}
+
+	if(job->current_view.offset >= job->current_view.length) {
+		end_parse_job_section(job);
+	}
+
+	return NO_ERROR();
+}
+
+[[nodiscard]] AssParseStatus parse_ass_step(AssParseJob* job, AssParseBudget budget) {
+
+	uint64_t start_time = budget.max_microseconds != 0 ? get_current_microseconds() : 0;
+	size_t step_lines = 0;
+
+	while(!job->is_done) {
+
+		if(atomic_load(&(job->is_cancelled))) {
+			return AssParseStatusCancelled;
+		}
+
+		if(budget.max_lines != 0 && step_lines >= budget.max_lines) {
+			return AssParseStatusContinue;
+		}
+
+		// a clock, that went backwards, ends the step too
+		if(budget.max_microseconds != 0 &&
+		   get_current_microseconds() - start_time >= budget.max_microseconds) {
+			return AssParseStatusContinue;
+		}
+
+		size_t block_lines = PARSE_STEP_BLOCK_LINES;
+
+		if(budget.max_lines != 0 && budget.max_lines - step_lines < block_lines) {
+			block_lines = budget.max_lines - step_lines;
+		}
+
+		size_t parsed_lines = 0;
+
+		// the progress callback runs outside of the arena, as its allocations aren't owned by the
+		// result
+		ThreadAllocation previous_allocation = use_result_allocation(job->result);
+
+		ErrorStruct error = parse_job_block(job, block_lines, &parsed_lines);
+
+		set_thread_allocation(previous_allocation);
+
+		step_lines += parsed_lines;
+		job->progress.parsed_lines += parsed_lines;
+
+		if(error.message != NULL) {
+			fail_parse_job(job, error);
+		}
+
+		if(budget.progress_callback != NULL) {
+			budget.progress_callback(job->progress, budget.user_data);
+		}
+	}
+
+	return AssParseStatusDone;
+}
+
+[[nodiscard]] AssParseProgress parse_ass_get_progress(AssParseJob* job) {
+	return job->progress;
+}
+
+void parse_ass_cancel(AssParseJob* job) {
+	atomic_store(&(job->is_cancelled), true);
+}
+
+[[nodiscard]] AssParseResult* parse_ass_finish(AssParseJob* job) {
+
+	AssParseResult* result = job->result;
+
+	if(!job->is_done) {
+		fail_parse_job(job, atomic_load(&(job->is_cancelled))
+		                        ? STATIC_ERROR("the parse was cancelled")
+		                        : STATIC_ERROR("the parse is not finished"));
+	} else if(!result->is_error) {
+		ThreadAllocation previous_allocation = use_result_allocation(result);
+		update_event_indices(result);
+		set_thread_allocation(previous_allocation);
+	}
+
+	allocator_free(result->settings.allocator, job);
+
+	return result;
+}
+
+typedef struct {
+	// codepoint offsets into the previous data
+	size_t start;
+	size_t end;
+	Codepoints replacement;
+	// the sum of the size changes of all previous edits
+	ptrdiff_t delta_before;
+} CodepointEdit;
+
+typedef struct {
+	Codepoints old_data;
+	Codepoints new_data;
+	STBDS_ARRAY(CodepointEdit) edits;
+} SourceRebase;
+
+// a line aligned range, that has to be parsed again, in the previous and in the new data
+typedef struct {
+	size_t old_start;
+	size_t old_end;
+	size_t new_start;
+	size_t new_end;
+	size_t section_index;
+} ReparseRange;
+
+[[nodiscard]] static size_t get_encoded_codepoint_size(FileType file_type, int32_t codepoint) {
+	switch(file_type) {
+		case FileTypeUtf16BE:
+		case FileTypeUtf16LE: return codepoint >= 0x10000 ? 4 : 2;
+		case FileTypeUtf32BE:
+		case FileTypeUtf32LE: return 4;
+		case FileTypeUnknown:
+		case FileTypeUtf8:
+		default: {
+			if(codepoint < 0x80) {
+				return 1;
+			}
+
+			if(codepoint < 0x800) {
+				return 2;
+			}
+
+			return codepoint < 0x10000 ? 3 : 4;
+		}
+	}
+}
+
+[[nodiscard]] static CodepointsResult get_codepoints_for_file_type(SizedPtr data,
+                                                                  FileType file_type) {
+	switch(file_type) {
+		case FileTypeUnknown:
+		case FileTypeUtf8: return get_codepoints_from_utf8(data);
+		case FileTypeUtf16BE: return get_codepoints_from_utf16(data, true);
+		case FileTypeUtf16LE: return get_codepoints_from_utf16(data, false);
+		case FileTypeUtf32BE: return get_codepoints_from_utf32(data, true);
+		case FileTypeUtf32LE: return get_codepoints_from_utf32(data, false);
+		default:
+			return (CodepointsResult){ .has_error = true,
+				                       .data = { .error = "unsupported file type" } };
+	}
+}
+
+// writes the bytes of the codepoint in the encoding of the file type and returns their amount
+[[nodiscard]] static size_t encode_codepoint(FileType file_type, int32_t codepoint,
+                                             uint8_t* buffer) {
+
+	size_t size = get_encoded_codepoint_size(file_type, codepoint);
+	uint32_t value = (uint32_t)codepoint;
+
+	switch(file_type) {
+		case FileTypeUtf16BE:
+		case FileTypeUtf16LE: {
+			uint16_t units[2] = { (uint16_t)value, 0 };
+
+			if(size == 4) {
+				units[0] = (uint16_t)(0xD800 + ((value - 0x10000) >> 10));
+				units[1] = (uint16_t)(0xDC00 + ((value - 0x10000) & 0x3FF));
+			}
+
+			for(size_t i = 0; i < size / 2; ++i) {
+				uint8_t high = (uint8_t)(units[i] >> 8);
+				uint8_t low = (uint8_t)(units[i] & 0xFF);
+
+				buffer[i * 2] = file_type == FileTypeUtf16BE ? high : low;
+				buffer[(i * 2) + 1] = file_type == FileTypeUtf16BE ? low : high;
+			}
+
+			return size;
+		}
+		case FileTypeUtf32BE:
+		case FileTypeUtf32LE: {
+			for(size_t i = 0; i < 4; ++i) {
+				size_t shift = file_type == FileTypeUtf32BE ? (3 - i) * 8 : i * 8;
+				buffer[i] = (uint8_t)(value >> shift);
+			}
+
+			return size;
+		}
+		case FileTypeUnknown:
+		case FileTypeUtf8:
+		default: {
+			if(size == 1) {
+				buffer[0] = (uint8_t)value;
+				return size;
+			}
+
+			// the marker bits of the first byte of a sequence of 2, 3 or 4 bytes
+			const uint8_t first_byte_markers[5] = { 0, 0, 0xC0, 0xE0, 0xF0 };
+
+			for(size_t i = size - 1; i > 0; --i) {
+				buffer[i] = (uint8_t)(0x80 | (value & 0x3F));
+				value >>= 6;
+			}
+
+			buffer[0] = (uint8_t)(first_byte_markers[size] | value);
+
+			return size;
+		}
+	}
+}
+
+// the codepoints came from valid bytes of the file type, so this gives back exactly these bytes
+[[nodiscard]] static bool encode_codepoints(Codepoints data, FileType file_type,
+                                            SizedPtr* result) {
+
+	size_t size = 0;
+
+	for(size_t i = 0; i < data.size; ++i) {
+		size += get_encoded_codepoint_size(file_type, data.data[i]);
+	}
+
+	uint8_t* buffer = (uint8_t*)ass_malloc(size);
+
+	if(!buffer) {
+		return false;
+	}
+
+	size_t offset = 0;
+
+	for(size_t i = 0; i < data.size; ++i) {
+		offset += encode_codepoint(file_type, data.data[i], buffer + offset);
+	}
+
+	*result = (SizedPtr){ .data = buffer, .len = size };
+	return true;
+}
+
+[[nodiscard]] static ErrorStruct apply_byte_edits(SizedPtr source, AssSourceEdits edits,
+                                                  SizedPtr* result) {
+
+	size_t new_size = source.len;
+	size_t previous_end = 0;
+
+	for(size_t i = 0; i < stbds_arrlenu(edits.entries); ++i) {
+		AssSourceEdit edit = edits.entries[i];
+
+		if(edit.start > edit.end || edit.start < previous_end) {
+			return STATIC_ERROR("the edits have to be sorted and may not overlap");
+		}
+
+		if(edit.end > source.len) {
+			char* result_buffer = NULL;
+			FORMAT_STRING_DEFAULT(&result_buffer, "the edit offset %lu is out of range",
+			                      edit.end);
+
+			return DYNAMIC_ERROR(result_buffer);
+		}
+
+		new_size = new_size - (edit.end - edit.start) + edit.replacement.len;
+		previous_end = edit.end;
+	}
+
+	// an empty source has no data, like an empty file
+	if(new_size == 0) {
+		*result = (SizedPtr){ .data = NULL, .len = 0 };
+		return NO_ERROR();
+	}
+
+	uint8_t* buffer = (uint8_t*)ass_malloc(new_size);
+
+	if(!buffer) {
+		return STATIC_ERROR("allocation error");
+	}
+
+	size_t read_offset = 0;
+	size_t write_offset = 0;
+
+	for(size_t i = 0; i < stbds_arrlenu(edits.entries); ++i) {
+		AssSourceEdit edit = edits.entries[i];
+
+		if(edit.start > read_offset) {
+			memcpy(buffer + write_offset, (uint8_t*)source.data + read_offset,
+			       edit.start - read_offset);
+			write_offset += edit.start - read_offset;
+		}
+
+		if(edit.replacement.len > 0) {
+			memcpy(buffer + write_offset, edit.replacement.data, edit.replacement.len);
+			write_offset += edit.replacement.len;
+		}
+
+		read_offset = edit.end;
+	}
+
+	if(source.len > read_offset) {
+		memcpy(buffer + write_offset, (uint8_t*)source.data + read_offset,
+		       source.len - read_offset);
+	}
+
+	*result = (SizedPtr){ .data = buffer, .len = new_size };
+	return NO_ERROR();
+}
+
+// applies the edits to the bytes of the source (that are consumed) and decodes all of them, used,
+// when the edits can't be applied to the codepoints, e.g. if an edit splits a character, the
+// bytes, that can't be decoded or edited, are kept in raw_source
+[[nodiscard]] static ErrorStruct decode_edited_source(RawSource source, FileType file_type,
+                                                      AssSourceEdits edits, Codepoints* result,
+                                                      RawSource* raw_source) {
+
+	SizedPtr edited_source = { .data = NULL, .len = 0 };
+
+	ErrorStruct error = apply_byte_edits(source.data, edits, &edited_source);
+
+	if(error.message != NULL) {
+		// the source stays as it was, so that the edits can be given again
+		*raw_source = source;
+		return error;
+	}
+
+	ass_free(source.data.data);
+
+	if(edited_source.len == 0) {
+		*result = (Codepoints){ .data = NULL, .size = 0 };
+		return NO_ERROR();
+	}
+
+	CodepointsResult codepoints_result = get_codepoints_for_file_type(edited_source, file_type);
+
+	if(codepoints_result.has_error) {
+		*raw_source = (RawSource){ .is_present = true, .data = edited_source };
+		return STATIC_ERROR(codepoints_result.data.error);
+	}
+
+	ass_free(edited_source.data);
+
+	*result = codepoints_result.data.result;
+	return NO_ERROR();
+}
+
+[[nodiscard]] static ptrdiff_t get_edit_delta(CodepointEdit edit) {
+	return (ptrdiff_t)edit.replacement.size - (ptrdiff_t)(edit.end - edit.start);
+}
+
+static void free_codepoint_edits(STBDS_ARRAY(CodepointEdit) edits) {
+	for(size_t i = 0; i < stbds_arrlenu(edits); ++i) {
+		free_codepoints(edits[i].replacement);
+	}
+
+	stbds_arrfree(edits);
+}
+
+// converts the byte offsets of the edits into codepoint offsets and decodes the replacements
+[[nodiscard]] static ErrorStruct get_codepoint_edits(Codepoints data, FileType file_type,
+                                                     AssSourceEdits edits,
+                                                     STBDS_ARRAY(CodepointEdit) * result) {
+
+	STBDS_ARRAY(CodepointEdit) codepoint_edits = STBDS_ARRAY_EMPTY;
+
+	size_t byte_offset = 0;
+	size_t codepoint_offset = 0;
+	ptrdiff_t delta = 0;
+
+	for(size_t i = 0; i < stbds_arrlenu(edits.entries); ++i) {
+		AssSourceEdit edit = edits.entries[i];
+
+		if(edit.start > edit.end || edit.start < byte_offset) {
+			free_codepoint_edits(codepoint_edits);
+			return STATIC_ERROR("the edits have to be sorted and may not overlap");
+		}
+
+		size_t byte_offsets[2] = { edit.start, edit.end };
+		size_t codepoint_offsets[2] = { 0, 0 };
+
+		for(size_t j = 0; j < 2; ++j) {
+			while(byte_offset < byte_offsets[j] && codepoint_offset < data.size) {
+				byte_offset += get_encoded_codepoint_size(file_type, data.data[codepoint_offset]);
+				++codepoint_offset;
+			}
+
+			if(byte_offset != byte_offsets[j]) {
+				free_codepoint_edits(codepoint_edits);
+
+				char* result_buffer = NULL;
+				FORMAT_STRING_DEFAULT(&result_buffer,
+				                      "the edit offset %lu is out of range or not at the start of "
+				                      "a character",
+				                      byte_offsets[j]);
+
+				return DYNAMIC_ERROR(result_buffer);
+			}
+
+			codepoint_offsets[j] = codepoint_offset;
+		}
+
+		Codepoints replacement = { .data = NULL, .size = 0 };
+
+		if(edit.replacement.len > 0) {
+			CodepointsResult replacement_result =
+			    get_codepoints_for_file_type(edit.replacement, file_type);
+
+			if(replacement_result.has_error) {
+				free_codepoint_edits(codepoint_edits);
+				return STATIC_ERROR(replacement_result.data.error);
+			}
+
+			replacement = replacement_result.data.result;
+		}
+
+		CodepointEdit codepoint_edit = { .start = codepoint_offsets[0],
+			                             .end = codepoint_offsets[1],
+			                             .replacement = replacement,
+			                             .delta_before = delta };
+
+		delta += get_edit_delta(codepoint_edit);
+
+		stbds_arrput(codepoint_edits, codepoint_edit);
+	}
+
+	*result = codepoint_edits;
+	return NO_ERROR();
+}
+
+[[nodiscard]] static ErrorStruct apply_codepoint_edits(Codepoints data,
+                                                       STBDS_ARRAY(CodepointEdit) edits,
+                                                       Codepoints* result) {
+
+	size_t edit_count = stbds_arrlenu(edits);
+
+	size_t new_size = data.size;
+
+	if(edit_count > 0) {
+		CodepointEdit last_edit = edits[edit_count - 1];
+		new_size = (size_t)((ptrdiff_t)data.size + last_edit.delta_before +
+		                    get_edit_delta(last_edit));
+	}
+
+	if(new_size == 0) {
+		*result = (Codepoints){ .data = NULL, .size = 0 };
+		return NO_ERROR();
+	}
+
+	int32_t* buffer = (int32_t*)ass_malloc(sizeof(int32_t) * new_size);
+
+	if(!buffer) {
+		return STATIC_ERROR("allocation error");
+	}
+
+	size_t read_offset = 0;
+	size_t write_offset = 0;
+
+	for(size_t i = 0; i < edit_count; ++i) {
+		CodepointEdit edit = edits[i];
+
+		memcpy(buffer + write_offset, data.data + read_offset,
+		       sizeof(int32_t) * (edit.start - read_offset));
+		write_offset += edit.start - read_offset;
+
+		if(edit.replacement.size > 0) {
+			memcpy(buffer + write_offset, edit.replacement.data,
+			       sizeof(int32_t) * edit.replacement.size);
+			write_offset += edit.replacement.size;
+		}
+
+		read_offset = edit.end;
+	}
+
+	memcpy(buffer + write_offset, data.data + read_offset,
+	       sizeof(int32_t) * (data.size - read_offset));
+
+	*result = (Codepoints){ .data = buffer, .size = new_size };
+	return NO_ERROR();
+}
+
+// the new offset of a position in the previous data, that is not inside of an edit, an insertion
+// at exactly this position ends up after it
+[[nodiscard]] static size_t get_rebased_offset(STBDS_ARRAY(CodepointEdit) edits, size_t offset) {
+
+	size_t low = 0;
+	size_t high = stbds_arrlenu(edits);
+
+	while(low < high) {
+		size_t middle = low + ((high - low) / 2);
+
+		if(edits[middle].start < offset) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	if(low == 0) {
+		return offset;
+	}
+
+	CodepointEdit last_edit = edits[low - 1];
+
+	return (size_t)((ptrdiff_t)offset + last_edit.delta_before + get_edit_delta(last_edit));
+}
+
+// insertions at the end of the data extend the range, that ends there
+[[nodiscard]] static size_t get_rebased_end_offset(SourceRebase rebase, size_t offset) {
+
+	if(offset == rebase.old_data.size) {
+		return rebase.new_data.size;
+	}
+
+	return get_rebased_offset(rebase.edits, offset);
+}
+
+[[nodiscard]] static bool is_in_data(Codepoints data, const int32_t* ptr) {
+	return ptr != NULL && ptr >= data.data && ptr <= data.data + data.size;
+}
+
+// views, that don't point into the previous data (e.g. the default strings) are left as is
+static void rebase_str(FinalStr* str, SourceRebase rebase) {
+
+	if(!is_in_data(rebase.old_data, str->start)) {
+		return;
+	}
+
+	size_t offset = (size_t)(str->start - rebase.old_data.data);
+
+	str->start = rebase.new_data.data + get_rebased_offset(rebase.edits, offset);
+}
+
+static void rebase_script_info(AssScriptInfo* script_info, SourceRebase rebase) {
+	rebase_str(&(script_info->title), rebase);
+	rebase_str(&(script_info->original_script), rebase);
+	rebase_str(&(script_info->original_translation), rebase);
+	rebase_str(&(script_info->original_editing), rebase);
+	rebase_str(&(script_info->original_timing), rebase);
+	rebase_str(&(script_info->synch_point), rebase);
+	rebase_str(&(script_info->script_updated_by), rebase);
+	rebase_str(&(script_info->update_details), rebase);
+	rebase_str(&(script_info->collisions), rebase);
+	rebase_str(&(script_info->play_depth), rebase);
+	rebase_str(&(script_info->timer), rebase);
+	rebase_str(&(script_info->ycbcr_matrix), rebase);
+}
+
+static void rebase_event_entry(AssEventEntry* entry, SourceRebase rebase) {
+	rebase_str(&(entry->style), rebase);
+	rebase_str(&(entry->name), rebase);
+	rebase_str(&(entry->effect), rebase);
+	rebase_str(&(entry->text), rebase);
+}
+
+static void rebase_extra_sections(ExtraSections* extra_sections, SourceRebase rebase) {
+	for(size_t i = 0; i < stbds_shlenu(extra_sections->entries); ++i) {
+		ExtraSectionEntry* entry = &(extra_sections->entries[i].value);
+
+		for(size_t j = 0; j < stbds_shlenu(entry->fields); ++j) {
+			rebase_str(&(entry->fields[j].value), rebase);
+		}
+	}
+}
+
+[[nodiscard]] static size_t get_line_start(Codepoints data, size_t position, LineType line_type) {
+
+	int32_t line_end = line_type == LineTypeCr ? '\r' : '\n';
+
+	for(size_t i = position; i > 0; --i) {
+		if(data.data[i - 1] == line_end) {
+			return i;
+		}
+	}
+
+	return 0;
+}
+
+// counts the lines of a line aligned range like skip_section, so a last line without a line
+// ending is a line too
+[[nodiscard]] static size_t get_line_count(Codepoints data, size_t start, size_t end,
+                                           LineType line_type) {
+
+	int32_t line_end = line_type == LineTypeCr ? '\r' : '\n';
+
+	size_t count = 0;
+
+	for(size_t i = start; i < end; ++i) {
+		if(data.data[i] == line_end) {
+			++count;
+		}
+	}
+
+	if(end > start && data.data[end - 1] != line_end) {
+		++count;
+	}
+
+	return count;
+}
+
+[[nodiscard]] static bool range_has_line_starting_with(Codepoints data, size_t start, size_t end,
+                                                       LineType line_type, const char* ascii_str) {
+
+	StrView view = { .start = data.data, .offset = start, .length = end };
+
+	while(!str_view_is_eof(view)) {
+		if(str_view_starts_with_ascii(view, ascii_str)) {
+			return true;
+		}
+
+		view.offset = get_next_line_start(view, view.offset, line_type);
+	}
+
+	return false;
+}
+
+// the edits may introduce line endings, that don't match the line type of the file, which would
+// make get_line_type fail in a full parse
+[[nodiscard]] static bool range_has_only_line_endings_of_type(Codepoints data, size_t start,
+                                                              size_t end, LineType line_type) {
+
+	for(size_t i = start; i < end; ++i) {
+		int32_t codepoint = data.data[i];
+
+		if(codepoint == '\r') {
+			if(line_type == LineTypeLf) {
+				return false;
+			}
+
+			if(line_type == LineTypeCrLf && (i + 1 >= end || data.data[i + 1] != '\n')) {
+				return false;
+			}
+		} else if(codepoint == '\n') {
+			if(line_type == LineTypeCr) {
+				return false;
+			}
+
+			if(line_type == LineTypeCrLf && (i == start || data.data[i - 1] != '\r')) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// returns the offset after the format line of the section, or 0, if there is none
+[[nodiscard]] static size_t get_format_line_end(Codepoints data, AssSectionEntry section,
+                                                LineType line_type) {
+
+	StrView section_view = get_str_view_for_section(data, section);
+
+	while(!str_view_is_eof(section_view)) {
+		size_t line_end = get_next_line_start(section_view, section_view.offset, line_type);
+
+		if(str_view_starts_with_ascii(section_view, "Format:")) {
+			return line_end;
+		}
+
+		section_view.offset = line_end;
+	}
+
+	return 0;
+}
+
+[[nodiscard]] static bool has_multiple_sections_with_name(AssSections sections,
+                                                          AssSectionEntry section) {
+
+	size_t count = 0;
+
+	for(size_t i = 0; i < stbds_arrlenu(sections.entries); ++i) {
+		if(str_view_eq_str_view(sections.entries[i].name, section.name)) {
+			++count;
+		}
+	}
+
+	return count > 1;
+}
+
+// the text field is the last field of every event line, so its start identifies the line
+[[nodiscard]] static size_t get_event_entry_offset(AssEventEntry entry, Codepoints data) {
+	return (size_t)(entry.text.start - data.data);
+}
+
+// the index of the first event, that starts at or after the offset
+[[nodiscard]] static size_t get_event_index_for_offset(AssEvents events, Codepoints data,
+                                                       size_t offset) {
+
+	size_t low = 0;
+	size_t high = stbds_arrlenu(events.entries);
+
+	while(low < high) {
+		size_t middle = low + ((high - low) / 2);
+
+		if(get_event_entry_offset(events.entries[middle], data) < offset) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+static void remove_event_from_counts(AssEvents* events, AssEventEntry entry) {
+	if(entry.type == EventTypeDialogue) {
+		events->dialogue_count--;
+	} else if(entry.type == EventTypeComment) {
+		events->comment_count--;
+	}
+}
+
+// keeps all untouched events (with moved views) and replaces the events of the ranges with the
+// newly parsed lines
+[[nodiscard]] static ErrorStruct
+reparse_event_ranges(AssEvents* events, AssSectionEntry section,
+                     STBDS_ARRAY(ReparseRange) ranges, SourceRebase rebase,
+                     ParseSettings settings, LineType line_type, Warnings* warnings,
+                     RecoveredErrors* errors) {
+
+	EventsParseState state = {
+		.event_format = STBDS_ARRAY_EMPTY,
+		.event_program = { .instructions = STBDS_ARRAY_EMPTY, .is_canonical = false },
+		.events = { .entries = STBDS_ARRAY_EMPTY, .dialogue_count = 0, .comment_count = 0 },
+	};
+
+	StrView section_view = get_str_view_for_section(rebase.new_data, section);
+
+	ErrorStruct error =
+	    parse_event_lines(&state, &section_view, settings, line_type, true, warnings, errors);
+
+	if(error.message != NULL) {
+		free_events_parse_state(state);
+		return error;
+	}
+
+	STBDS_ARRAY(AssEventEntry) entries = STBDS_ARRAY_EMPTY;
+	stbds_arrsetcap(entries, stbds_arrlenu(events->entries));
+
+	size_t event_index = 0;
+
+	for(size_t i = 0; i < stbds_arrlenu(ranges); ++i) {
+		ReparseRange range = ranges[i];
+
+		size_t first_removed =
+		    get_event_index_for_offset(*events, rebase.old_data, range.old_start);
+		size_t last_removed = get_event_index_for_offset(*events, rebase.old_data, range.old_end);
+
+		for(; event_index < first_removed; ++event_index) {
+			AssEventEntry entry = events->entries[event_index];
+			rebase_event_entry(&entry, rebase);
+			stbds_arrput(entries, entry);
+		}
+
+		for(; event_index < last_removed; ++event_index) {
+			remove_event_from_counts(events, events->entries[event_index]);
+		}
+
+		StrView range_view = { .start = rebase.new_data.data,
+			                   .offset = range.new_start,
+			                   .length = range.new_end };
+
+		error =
+		    parse_event_lines(&state, &range_view, settings, line_type, false, warnings, errors);
+
+		if(error.message != NULL) {
+			stbds_arrfree(entries);
+			free_events_parse_state(state);
+			return error;
+		}
+
+		for(size_t j = 0; j < stbds_arrlenu(state.events.entries); ++j) {
+			stbds_arrput(entries, state.events.entries[j]);
+		}
+
+		events->dialogue_count += state.events.dialogue_count;
+		events->comment_count += state.events.comment_count;
+
+		stbds_arrfree(state.events.entries);
+		state.events.dialogue_count = 0;
+		state.events.comment_count = 0;
+	}
+
+	for(; event_index < stbds_arrlenu(events->entries); ++event_index) {
+		AssEventEntry entry = events->entries[event_index];
+		rebase_event_entry(&entry, rebase);
+		stbds_arrput(entries, entry);
+	}
+
+	free_events_parse_state(state);
+
+	stbds_arrfree(events->entries);
+	events->entries = entries;
+
+	return NO_ERROR();
+}
+
+[[nodiscard]] static bool is_offset_in_ranges(size_t offset, AssSections sections,
+                                              const bool* dirty_sections,
+                                              STBDS_ARRAY(ReparseRange) ranges) {
+
+	for(size_t i = 0; i < stbds_arrlenu(sections.entries); ++i) {
+		if(dirty_sections[i] && offset >= sections.entries[i].header_start &&
+		   offset < sections.entries[i].end) {
+			return true;
+		}
+	}
+
+	for(size_t i = 0; i < stbds_arrlenu(ranges); ++i) {
+		if(offset >= ranges[i].old_start && offset < ranges[i].old_end) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// returns NULL, if the warning has no view into the source
+[[nodiscard]] static FinalStr* get_warning_view(WarningEntry* entry) {
+	switch(entry->type) {
+		case WarningTypeUnexpectedField: return &(entry->data.unexpected_field.field);
+		case WarningTypeDuplicateField: return &(entry->data.duplicate_field.field);
+		case WarningTypeTruncatedNumber: return &(entry->data.truncated_number.value);
+		case WarningTypeUnknownStyle: return &(entry->data.unknown_style.style);
+		case WarningTypeSimple:
+		case WarningTypeMissingScriptType:
+		case WarningTypeUnrecognizedFileType:
+		default: return NULL;
+	}
+}
+
+// warnings of the parts, that are parsed again, are reported again by that parse, warnings
+// without a position (like the file type one) can't be attributed and are kept, except the missing
+// script type one, that belongs to the script info section
+static void rebase_warnings(Warnings* warnings, AssSections sections, const bool* dirty_sections,
+                            STBDS_ARRAY(ReparseRange) ranges, SourceRebase rebase) {
+
+	size_t kept = 0;
+
+	for(size_t i = 0; i < stbds_arrlenu(warnings->entries); ++i) {
+		WarningEntry entry = warnings->entries[i];
+
+		// these are built again, after the events are resolved again
+		if(entry.type == WarningTypeUnknownStyle) {
+			continue;
+		}
+
+		// the script info section is always the first one
+		if(entry.type == WarningTypeMissingScriptType && stbds_arrlenu(sections.entries) > 0 &&
+		   dirty_sections[0]) {
+			continue;
+		}
+
+		FinalStr* field = get_warning_view(&entry);
+
+		if(field != NULL && is_in_data(rebase.old_data, field->start)) {
+			size_t offset = (size_t)(field->start - rebase.old_data.data);
+
+			if(is_offset_in_ranges(offset, sections, dirty_sections, ranges)) {
+				continue;
+			}
+
+			rebase_str(field, rebase);
+		}
+
+		warnings->entries[kept] = entry;
+		++kept;
+	}
+
+	stbds_arrsetlen(warnings->entries, kept);
+}
+
+// returns false, if the edits can't be handled incrementally, the result is untouched in that
+// case, otherwise the result now uses the new data, the error is set, if the new data has an error
+[[nodiscard]] static bool reparse_incremental(AssParseResult* result, SourceRebase rebase,
+                                              ErrorStruct* error) {
+
+	AssResult* ass_result = &(result->data.ok);
+	AssSections sections = result->sections;
+	LineType line_type = ass_result->file_props.line_type;
+	size_t section_count = stbds_arrlenu(sections.entries);
+
+	STBDS_ARRAY(ReparseRange) ranges = STBDS_ARRAY_EMPTY;
+
+	StrView old_view = str_view_from_data(rebase.old_data);
+
+	for(size_t i = 0; i < stbds_arrlenu(rebase.edits); ++i) {
+		CodepointEdit edit = rebase.edits[i];
+
+		size_t old_start = get_line_start(rebase.old_data, edit.start, line_type);
+		size_t old_end = get_next_line_start(old_view, edit.end, line_type);
+
+		size_t range_count = stbds_arrlenu(ranges);
+
+		if(range_count > 0 && old_start < ranges[range_count - 1].old_end) {
+			if(old_end > ranges[range_count - 1].old_end) {
+				ranges[range_count - 1].old_end = old_end;
+			}
+			continue;
+		}
+
+		ReparseRange range = { .old_start = old_start, .old_end = old_end };
+		stbds_arrput(ranges, range);
+	}
+
+	bool* dirty_sections = (bool*)ass_malloc(sizeof(bool) * section_count);
+
+	if(!dirty_sections) {
+		stbds_arrfree(ranges);
+		return false;
+	}
+
+	memset(dirty_sections, 0, sizeof(bool) * section_count);
+
+	bool handled = true;
+
+	STBDS_ARRAY(ReparseRange) event_ranges = STBDS_ARRAY_EMPTY;
+	size_t events_section_index = section_count;
+
+	for(size_t i = 0; i < stbds_arrlenu(ranges) && handled; ++i) {
+		ReparseRange* range = &(ranges[i]);
+
+		range->new_start = get_rebased_offset(rebase.edits, range->old_start);
+		range->new_end = get_rebased_end_offset(rebase, range->old_end);
+
+		size_t section_index = section_count;
+
+		for(size_t j = 0; j < section_count; ++j) {
+			AssSectionEntry section = sections.entries[j];
+
+			if(range->old_start >= section.header_start &&
+			   (range->old_start < section.end ||
+			    (j == section_count - 1 && range->old_start == section.end))) {
+				section_index = j;
+				break;
+			}
+		}
+
+		// changes to section headers and ranges, that span multiple sections change the section
+		// table, so they need a full parse
+		if(section_index == section_count) {
+			handled = false;
+			break;
+		}
+
+		AssSectionEntry section = sections.entries[section_index];
+		range->section_index = section_index;
+
+		if(range->old_start < section.start || range->old_end > section.end ||
+		   range_has_line_starting_with(rebase.new_data, range->new_start, range->new_end,
+		                                line_type, "[") ||
+		   !range_has_only_line_endings_of_type(rebase.new_data, range->new_start,
+		                                        range->new_end, line_type)) {
+			handled = false;
+			break;
+		}
+
+		if(!section.parsed || dirty_sections[section_index]) {
+			continue;
+		}
+
+		// a replaced section would also replace the values of the other one
+		if(has_multiple_sections_with_name(sections, section)) {
+			handled = false;
+			break;
+		}
+
+		if(section_index == 0 || !str_view_eq_ascii(section.name, "Events")) {
+			dirty_sections[section_index] = true;
+			continue;
+		}
+
+		// only event lines after the format line can be parsed on their own
+		if(range->old_start < get_format_line_end(rebase.old_data, section, line_type) ||
+		   range_has_line_starting_with(rebase.new_data, range->new_start, range->new_end,
+		                                line_type, "Format:")) {
+			dirty_sections[section_index] = true;
+			continue;
+		}
+
+		events_section_index = section_index;
+		stbds_arrput(event_ranges, *range);
+	}
+
+	if(!handled) {
+		stbds_arrfree(event_ranges);
+		stbds_arrfree(ranges);
+		ass_free(dirty_sections);
+		return false;
+	}
+
+	if(events_section_index < section_count && dirty_sections[events_section_index]) {
+		stbds_arrfree(event_ranges);
+	}
+
+	// from here on, the result is changed
+	rebase_warnings(&(result->warnings), sections, dirty_sections, event_ranges, rebase);
+
+	for(size_t i = 0; i < stbds_arrlenu(ranges); ++i) {
+		ReparseRange range = ranges[i];
+
+		size_t old_line_count =
+		    get_line_count(rebase.old_data, range.old_start, range.old_end, line_type);
+		size_t new_line_count =
+		    get_line_count(rebase.new_data, range.new_start, range.new_end, line_type);
+
+		sections.entries[range.section_index].line_count += new_line_count - old_line_count;
+	}
+
+	for(size_t i = 0; i < section_count; ++i) {
+		AssSectionEntry* section = &(sections.entries[i]);
+
+		section->header_start = get_rebased_offset(rebase.edits, section->header_start);
+		section->start = get_rebased_offset(rebase.edits, section->start);
+		section->end = get_rebased_end_offset(rebase, section->end);
+		rebase_str(&(section->name), rebase);
+	}
+
+	rebase_script_info(&(ass_result->script_info), rebase);
+
+	for(size_t i = 0; i < stbds_arrlenu(ass_result->styles.entries); ++i) {
+		rebase_str(&(ass_result->styles.entries[i].name), rebase);
+		rebase_str(&(ass_result->styles.entries[i].fontname), rebase);
+	}
+
+	rebase_extra_sections(&(ass_result->extra_sections), rebase);
+
+	bool has_event_ranges = stbds_arrlenu(event_ranges) > 0;
+
+	if(!has_event_ranges) {
+		for(size_t i = 0; i < stbds_arrlenu(ass_result->events.entries); ++i) {
+			rebase_event_entry(&(ass_result->events.entries[i]), rebase);
+		}
+	}
+
+	*error = NO_ERROR();
+
+	// in section order, so that the first error is the same as in a full parse
+	for(size_t i = 0; i < section_count && error->message == NULL; ++i) {
+		if(has_event_ranges && i == events_section_index) {
+			*error = reparse_event_ranges(&(ass_result->events), sections.entries[i], event_ranges,
+			                              rebase, result->settings, line_type, &(result->warnings),
+			                              &(result->recovered_errors));
+			continue;
+		}
+
+		if(!dirty_sections[i]) {
+			continue;
+		}
+
+		SectionJob job = {
+			.section = sections.entries[i],
+			.is_script_info = i == 0,
+			.result = { .extra_sections = (ExtraSections){ .entries = STBDS_HASH_MAP_EMPTY } },
+			.warnings = { .entries = STBDS_ARRAY_EMPTY },
+			.error = NO_ERROR(),
+		};
+
+		run_section_job(&job, rebase.new_data, result->settings, line_type);
+
+		move_warnings(&(result->warnings), &(job.warnings));
+
+		if(job.error.message != NULL) {
+			*error = job.error;
+			free_ass_result(job.result);
+			break;
+		}
+
+		merge_section_result(ass_result, &job);
+	}
+
+	stbds_arrfree(event_ranges);
+	stbds_arrfree(ranges);
+	ass_free(dirty_sections);
+
+	free_codepoints(result->allocated_codepoints);
+	result->allocated_codepoints = rebase.new_data;
+
+	return true;
+}
+
+[[nodiscard]] static AssParseResult* parse_ass_incremental_impl(AssParseResult* previous,
+                                                               AssSourceEdits edits) {
+
+	ParseSettings settings = previous->settings;
+	FileType file_type = previous->file_type;
+
+	STBDS_ARRAY(CodepointEdit) codepoint_edits = STBDS_ARRAY_EMPTY;
+	Codepoints new_data = { .data = NULL, .size = 0 };
+
+	// the bytes of the edited source, if they can't be decoded
+	RawSource raw_source = { .is_present = false, .data = { .data = NULL, .len = 0 } };
+	// without codepoint edits, only a full parse is possible
+	bool has_codepoint_edits = false;
+
+	ErrorStruct edits_error = NO_ERROR();
+
+	if(previous->raw_source.is_present) {
+		RawSource previous_source = previous->raw_source;
+		previous->raw_source = raw_source;
+
+		edits_error = decode_edited_source(previous_source, file_type, edits, &new_data,
+		                                   &raw_source);
+	} else if(previous->allocated_codepoints.data == NULL || previous->is_compacted) {
+		edits_error = STATIC_ERROR("the previous result has no source, that could be edited, "
+		                           "parse the source again with parse_ass");
+	} else if(settings.script_info_only) {
+		edits_error = STATIC_ERROR("the previous result only contains the script info section");
+	} else {
+		edits_error = get_codepoint_edits(previous->allocated_codepoints, file_type, edits,
+		                                  &codepoint_edits);
+
+		if(edits_error.message == NULL) {
+			has_codepoint_edits = true;
+			edits_error = apply_codepoint_edits(previous->allocated_codepoints, codepoint_edits,
+			                                    &new_data);
+		} else {
+			// the edits may still give a valid source, e.g. if one of them splits a character
+			SizedPtr previous_bytes = { .data = NULL, .len = 0 };
+
+			if(encode_codepoints(previous->allocated_codepoints, file_type, &previous_bytes)) {
+				free_error_struct(edits_error);
+				edits_error = decode_edited_source(
+				    (RawSource){ .is_present = true, .data = previous_bytes }, file_type, edits,
+				    &new_data, &raw_source);
+			}
+		}
+	}
+
+	if(edits_error.message != NULL) {
+		free_codepoint_edits(codepoint_edits);
+		set_thread_allocation((ThreadAllocation){ .allocator = settings.allocator, .arena = NULL });
+		free_parse_result(previous);
+
+		AssParseResult* result = alloc_parse_result(settings);
+
+		if(!result) {
+			ass_free(raw_source.data.data);
+			free_error_struct(edits_error);
+			return NULL;
+		}
+
+		result->file_type = file_type;
+		result->raw_source = raw_source;
+
+		RETURN_ERROR(edits_error);
+	}
+
+	// the locations of recovered errors are not rebased, so these results are always parsed again
+	if(!previous->is_error && has_codepoint_edits && new_data.data != NULL &&
+	   !settings.recover_from_errors) {
+		SourceRebase rebase = { .old_data = previous->allocated_codepoints,
+			                    .new_data = new_data,
+			                    .edits = codepoint_edits };
+
+		ErrorStruct reparse_error = NO_ERROR();
+
+		if(reparse_incremental(previous, rebase, &reparse_error)) {
+			free_codepoint_edits(codepoint_edits);
+
+			if(reparse_error.message != NULL) {
+				free_ass_result(previous->data.ok);
+				previous->is_error = true;
+				previous->data.error = reparse_error;
+			}
+
+			return previous;
+		}
+	}
+
+	free_codepoint_edits(codepoint_edits);
+
+	// the previous result is freed before the full parse, so the names can't be in its arena
+	set_thread_allocation((ThreadAllocation){ .allocator = settings.allocator, .arena = NULL });
+
+	// the sections, that were parsed on demand before, are parsed again after the full parse
+	bool parse_all_sections = true;
+	STBDS_ARRAY(char*) parsed_section_names = STBDS_ARRAY_EMPTY;
+
+	if(!previous->is_error) {
+		for(size_t i = 0; i < stbds_arrlenu(previous->sections.entries); ++i) {
+			AssSectionEntry section = previous->sections.entries[i];
+
+			if(!section.parsed) {
+				parse_all_sections = false;
+				continue;
+			}
+
+			char* name = alloc_normalized_string(section.name);
+
+			if(name != NULL) {
+				stbds_arrput(parsed_section_names, name);
+			}
+		}
+	}
+
+	free_parse_result(previous);
+
+	AssParseResult* result = alloc_parse_result(settings);
+
+	if(result != NULL) {
+		use_result_allocation(result);
+
+		if(file_type == FileTypeUnknown) {
+			add_unrecognized_file_type_warning(&(result->warnings));
+		}
+
+		result = parse_ass_codepoints(result, new_data, file_type, parse_all_sections);
+
+		for(size_t i = 0; i < stbds_arrlenu(parsed_section_names); ++i) {
+			if(parse_all_sections || result->is_error) {
+				break;
+			}
+
+			bool found_section = false;
+
+			ErrorStruct section_parse_result =
+			    parse_sections_with_name(result, parsed_section_names[i], &found_section);
+
+			if(section_parse_result.message != NULL) {
+				free_ass_result(result->data.ok);
+				result->is_error = true;
+				result->data.error = section_parse_result;
+			}
+		}
+	} else {
+		free_codepoints(new_data);
+	}
+
+	for(size_t i = 0; i < stbds_arrlenu(parsed_section_names); ++i) {
+		ass_free(parsed_section_names[i]);
+	}
+
+	stbds_arrfree(parsed_section_names);
+
+	return result;
+}
+
+[[nodiscard]] AssParseResult* parse_ass_incremental(AssParseResult* previous,
+                                                    AssSourceEdits edits) {
+
+	ThreadAllocation previous_allocation = use_result_allocation(previous);
+
+	AssParseResult* result = parse_ass_incremental_impl(previous, edits);
+
+	if(result != NULL && !result->is_error) {
+		// the result may be a new one, if the whole source was parsed again
+		use_result_allocation(result);
+		update_event_indices(result);
+	}
+
+	set_thread_allocation(previous_allocation);
+
+	return result;
+}
+
+#undef FREE_AT_END
+
+typedef struct {
+	size_t start;
+	size_t end;
+} SourceRange;
+
+static void add_source_range(STBDS_ARRAY(SourceRange) * ranges, Codepoints data, FinalStr str) {
+
+	// views, that don't point into the data (e.g. the default strings) don't need to be kept
+	if(!is_in_data(data, str.start)) {
+		return;
+	}
+
+	size_t start = (size_t)(str.start - data.data);
+	SourceRange range = { .start = start, .end = start + str.length };
+
+	stbds_arrput(*ranges, range);
+}
+
+static int compare_source_ranges(const void* first, const void* second) {
+
+	size_t first_start = ((const SourceRange*)first)->start;
+	size_t second_start = ((const SourceRange*)second)->start;
+
+	return (first_start > second_start) - (first_start < second_start);
+}
+
+// every view of the result, the sections are only named, their offsets are not views
+static void collect_source_ranges(AssParseResult* result, STBDS_ARRAY(SourceRange) * ranges) {
 
-				char* field_name = get_normalized_string(field);
+	Codepoints data = result->allocated_codepoints;
+	AssResult* ass_result = &(result->data.ok);
 
-				if(!field_name) {
-					FREE_AT_END();
-					return STATIC_ERROR("allocation error");
-				}
+	for(size_t i = 0; i < stbds_arrlenu(result->sections.entries); ++i) {
+		add_source_range(ranges, data, result->sections.entries[i].name);
+	}
 
-				char* result_buffer = NULL;
-				FORMAT_STRING_DEFAULT(&result_buffer, "unexpected field in events section: '%s'",
-				                      field_name);
+	AssScriptInfo* script_info = &(ass_result->script_info);
+	FinalStr script_info_strs[] = {
+		script_info->title,
+		script_info->original_script,
+		script_info->original_translation,
+		script_info->original_editing,
+		script_info->original_timing,
+		script_info->synch_point,
+		script_info->script_updated_by,
+		script_info->update_details,
+		script_info->collisions,
+		script_info->play_depth,
+		script_info->timer,
+		script_info->ycbcr_matrix,
+	};
+
+	for(size_t i = 0; i < sizeof(script_info_strs) / sizeof(*script_info_strs); ++i) {
+		add_source_range(ranges, data, script_info_strs[i]);
+	}
 
-				if(settings.strict_settings.allow_additional_fields) {
+	for(size_t i = 0; i < stbds_arrlenu(ass_result->styles.entries); ++i) {
+		add_source_range(ranges, data, ass_result->styles.entries[i].name);
+		add_source_range(ranges, data, ass_result->styles.entries[i].fontname);
+	}
 
-					UnexpectedFieldWarning unexpected_field = { .field = field,
-						                                        .section = "events" };
+	for(size_t i = 0; i < stbds_arrlenu(ass_result->events.entries); ++i) {
+		AssEventEntry entry = ass_result->events.entries[i];
+		add_source_range(ranges, data, entry.style);
+		add_source_range(ranges, data, entry.name);
+		add_source_range(ranges, data, entry.effect);
+		add_source_range(ranges, data, entry.text);
+	}
 
-					WarningEntry warning = { .type = WarningTypeUnexpectedField,
-						                     .data = { .unexpected_field = unexpected_field } };
+	for(size_t i = 0; i < stbds_arrlenu(ass_result->events.strings.entries); ++i) {
+		add_source_range(ranges, data, ass_result->events.strings.entries[i]);
+	}
 
-					stbds_arrput(warnings->entries, warning);
+	for(size_t i = 0; i < stbds_shlenu(ass_result->extra_sections.entries); ++i) {
+		ExtraSectionEntry entry = ass_result->extra_sections.entries[i].value;
 
-					free(result_buffer);
-					free(field_name);
-					continue;
-				}
+		for(size_t j = 0; j < stbds_shlenu(entry.fields); ++j) {
+			add_source_range(ranges, data, entry.fields[j].value);
+		}
+	}
 
-				free(field_name);
-				FREE_AT_END();
-				return DYNAMIC_ERROR(result_buffer);
-			}
+	for(size_t i = 0; i < stbds_arrlenu(result->warnings.entries); ++i) {
+		FinalStr* view = get_warning_view(&(result->warnings.entries[i]));
+
+		if(view != NULL) {
+			add_source_range(ranges, data, *view);
 		}
+	}
 
-		// end of line parse
+	for(size_t i = 0; i < stbds_arrlenu(result->recovered_errors.entries); ++i) {
+		add_source_range(ranges, data, result->recovered_errors.entries[i].location);
+	}
+}
 
-		if(str_view_is_eof(*data_view)) {
-			break;
+// every gap between the ranges becomes an edit, that removes it, empty ranges split the gaps, so
+// that their position stays valid too
+[[nodiscard]] static STBDS_ARRAY(CodepointEdit)
+    get_gap_removing_edits(STBDS_ARRAY(SourceRange) ranges, size_t data_size) {
+
+	STBDS_ARRAY(CodepointEdit) edits = STBDS_ARRAY_EMPTY;
+
+	size_t covered_end = 0;
+	ptrdiff_t delta = 0;
+
+	for(size_t i = 0; i <= stbds_arrlenu(ranges); ++i) {
+		bool is_end = i == stbds_arrlenu(ranges);
+		size_t next_start = is_end ? data_size : ranges[i].start;
+
+		if(next_start > covered_end) {
+			CodepointEdit edit = { .start = covered_end,
+				                   .end = next_start,
+				                   .replacement = { .data = NULL, .size = 0 },
+				                   .delta_before = delta };
+			stbds_arrput(edits, edit);
+
+			delta -= (ptrdiff_t)(next_start - covered_end);
+			covered_end = next_start;
+		}
+
+		if(!is_end && ranges[i].end > covered_end) {
+			covered_end = ranges[i].end;
 		}
 	}
 
-	stbds_arrfree(event_format);
-	*ass_events = events;
-	return NO_ERROR();
-	// end of script info
+	return edits;
 }
 
-#undef FREE_AT_END
+static void rebase_compacted_result(AssParseResult* result, SourceRebase rebase) {
 
-[[nodiscard]] static ErrorStruct get_section_by_name(ConstStrView section_name,
-                                                     AssResult* ass_result, StrView* data_view,
-                                                     ParseSettings settings, LineType line_type,
-                                                     Warnings* warnings) {
+	AssResult* ass_result = &(result->data.ok);
 
-	if(str_view_eq_ascii(section_name, "V4+ Styles")) {
-		return parse_styles(&(ass_result->styles), data_view, settings, line_type, warnings);
+	for(size_t i = 0; i < stbds_arrlenu(result->sections.entries); ++i) {
+		rebase_str(&(result->sections.entries[i].name), rebase);
 	}
 
-	if(str_view_eq_ascii(section_name, "V4 Styles")) {
-		return STATIC_ERROR("v4 styles are not supported");
+	rebase_script_info(&(ass_result->script_info), rebase);
+
+	for(size_t i = 0; i < stbds_arrlenu(ass_result->styles.entries); ++i) {
+		rebase_str(&(ass_result->styles.entries[i].name), rebase);
+		rebase_str(&(ass_result->styles.entries[i].fontname), rebase);
 	}
 
-	if(str_view_eq_ascii(section_name, "Events")) {
-		return parse_events(&(ass_result->events), data_view, settings, line_type, warnings);
+	for(size_t i = 0; i < stbds_arrlenu(ass_result->events.entries); ++i) {
+		rebase_event_entry(&(ass_result->events.entries[i]), rebase);
 	}
 
-	if(str_view_eq_ascii(section_name, "Fonts")) {
-		return skip_section(data_view, line_type);
+	for(size_t i = 0; i < stbds_arrlenu(ass_result->events.strings.entries); ++i) {
+		rebase_str(&(ass_result->events.strings.entries[i]), rebase);
 	}
 
-	if(str_view_eq_ascii(section_name, "Graphics")) {
-		return skip_section(data_view, line_type);
+	rebase_extra_sections(&(ass_result->extra_sections), rebase);
+
+	for(size_t i = 0; i < stbds_arrlenu(result->warnings.entries); ++i) {
+		FinalStr* view = get_warning_view(&(result->warnings.entries[i]));
+
+		if(view != NULL) {
+			rebase_str(view, rebase);
+		}
 	}
 
-	return extra_section(section_name, data_view, &(ass_result->extra_sections), line_type);
+	for(size_t i = 0; i < stbds_arrlenu(result->recovered_errors.entries); ++i) {
+		rebase_str(&(result->recovered_errors.entries[i].location), rebase);
+	}
+}
 
-	return NO_ERROR();
+// with interned strings, equal event strings are moved to their first occurrence, so that they are
+// only kept once
+static void use_interned_event_strings(AssEvents* events) {
+
+	if(stbds_arrlenu(events->strings.entries) == 0) {
+		return;
+	}
+
+	for(size_t i = 0; i < stbds_arrlenu(events->entries); ++i) {
+		AssEventEntry* entry = &(events->entries[i]);
+		entry->name = events->strings.entries[entry->name_id];
+		entry->effect = events->strings.entries[entry->effect_id];
+		entry->text = events->strings.entries[entry->text_id];
+	}
 }
 
-static void free_extra_section_entry(ExtraSectionEntry entry) {
-	size_t hm_length = stbds_shlenu(entry.fields);
+[[nodiscard]] static ErrorStruct compact_result(AssParseResult* result) {
 
-	for(size_t i = 0; i < hm_length; ++i) {
-		SectionFieldEntry hm_entry = entry.fields[i];
+	AssEvents* events = &(result->data.ok.events);
+
+	// the lazy fields are decoded from the source before the text, that is not kept
+	for(size_t i = 0; i < stbds_arrlenu(events->entries); ++i) {
+		ErrorStruct error = decode_event_fields(events, &(events->entries[i]), AssEventFieldAll);
 
-		free(hm_entry.key);
+		if(error.message != NULL) {
+			return error;
+		}
 	}
 
-	stbds_shfree(entry.fields);
-}
+	use_interned_event_strings(events);
 
-static void free_extra_sections(ExtraSections sections) {
+	STBDS_ARRAY(SourceRange) ranges = STBDS_ARRAY_EMPTY;
+	collect_source_ranges(result, &ranges);
 
-	size_t hm_length = stbds_shlenu(sections.entries);
+	qsort(ranges, stbds_arrlenu(ranges), sizeof(SourceRange), compare_source_ranges);
 
-	for(size_t i = 0; i < hm_length; ++i) {
-		ExtraSectionHashMapEntry entry = sections.entries[i];
+	Codepoints old_data = result->allocated_codepoints;
 
-		free_extra_section_entry(entry.value);
-		free(entry.key);
+	STBDS_ARRAY(CodepointEdit) edits = get_gap_removing_edits(ranges, old_data.size);
+	stbds_arrfree(ranges);
+
+	Codepoints new_data = { .data = NULL, .size = 0 };
+	ErrorStruct error = apply_codepoint_edits(old_data, edits, &new_data);
+
+	if(error.message != NULL) {
+		stbds_arrfree(edits);
+		return error;
 	}
 
-	stbds_shfree(sections.entries);
-}
+	SourceRebase rebase = { .old_data = old_data, .new_data = new_data, .edits = edits };
+	rebase_compacted_result(result, rebase);
 
-static void free_ass_result(AssResult data) {
-	stbds_arrfree(data.styles.entries);
-	stbds_arrfree(data.events.entries);
+	stbds_arrfree(edits);
 
-	free_extra_sections(data.extra_sections);
+	free_codepoints(old_data);
+	result->allocated_codepoints = new_data;
+	result->is_compacted = true;
+
+	return NO_ERROR();
 }
 
-#define FREE_AT_END() \
-	do { \
-	} while(false)
+[[nodiscard]] ErrorStruct parse_result_compact(AssParseResult* result) {
 
-#define RETURN_ERROR(err) \
-	do { \
-		FREE_AT_END(); \
-		result->is_error = true; \
-		result->data.error = err; \
-		return result; \
-	} while(false)
+	if(result->is_error) {
+		return STATIC_ERROR("can't compact a result, that is an error");
+	}
 
-[[nodiscard]] AssParseResult* parse_ass(AssSource source, ParseSettings settings) {
+	if(result->is_compacted) {
+		return NO_ERROR();
+	}
 
-	AssParseResult* result = (AssParseResult*)malloc(sizeof(AssParseResult));
+	ThreadAllocation previous_allocation = use_result_allocation(result);
 
-	if(!result) {
-		return NULL;
+	ErrorStruct error = compact_result(result);
+
+	set_thread_allocation(previous_allocation);
+
+	return error;
+}
+
+[[nodiscard]] static AssCompactStr get_compact_str(Codepoints source, FinalStr str) {
+	return (AssCompactStr){ .offset = (uint32_t)(str.start - source.data),
+		                    .length = (uint32_t)str.length };
+}
+
+[[nodiscard]] static ErrorStruct get_compact_margin(MarginValue margin, uint8_t default_flag,
+                                                    uint16_t* value, uint8_t* flags) {
+
+	if(margin.is_default) {
+		*value = 0;
+		*flags |= default_flag;
+		return NO_ERROR();
 	}
 
-	result->warnings = (Warnings){ .entries = STBDS_ARRAY_EMPTY };
-	result->allocated_codepoints = (Codepoints){ .data = NULL, .size = 0 };
+	if(margin.data.value > UINT16_MAX) {
+		return STATIC_ERROR("margin doesn't fit into the compact event layout");
+	}
+
+	*value = (uint16_t)margin.data.value;
+	return NO_ERROR();
+}
 
-	SizedPtr data = get_data_from_source(source);
+[[nodiscard]] static ErrorStruct get_compact_event(AssEventEntry entry, Codepoints source,
+                                                   AssCompactEvent* compact_event) {
 
-	if(is_ptr_error(data)) {
-		RETURN_ERROR(STATIC_ERROR(ptr_get_error(data)));
+	if(entry.layer > UINT32_MAX) {
+		return STATIC_ERROR("layer doesn't fit into the compact event layout");
 	}
 
-	FileType file_type = determine_file_type(data);
+	*compact_event = (AssCompactEvent){
+		.start = get_packed_time(entry.start),
+		.end = get_packed_time(entry.end),
+		.layer = (uint32_t)entry.layer,
+		.style_index = entry.style_index,
+		.name = get_compact_str(source, entry.name),
+		.effect = get_compact_str(source, entry.effect),
+		.text = get_compact_str(source, entry.text),
+		.margin_l = 0,
+		.margin_r = 0,
+		.margin_v = 0,
+		.type = entry.type,
+		.flags = 0,
+	};
+
+	ErrorStruct error = get_compact_margin(entry.margin_l, AssCompactEventFlagMarginLDefault,
+	                                       &(compact_event->margin_l), &(compact_event->flags));
+
+	if(error.message == NULL) {
+		error = get_compact_margin(entry.margin_r, AssCompactEventFlagMarginRDefault,
+		                           &(compact_event->margin_r), &(compact_event->flags));
+	}
 
-	size_t bom_size = 0;
-	CodepointsResult codepoints_result = { .has_error = true,
-		                                   .data = { .error = "implementation error" } };
+	if(error.message == NULL) {
+		error = get_compact_margin(entry.margin_v, AssCompactEventFlagMarginVDefault,
+		                           &(compact_event->margin_v), &(compact_event->flags));
+	}
 
-	switch(file_type) {
-		case FileTypeUnknown: {
-			const char* error = "unrecognized file type, no BOM present";
+	return error;
+}
 
-			if(!settings.strict_settings.allow_unrecognized_file_encoding) {
-				RETURN_ERROR(STATIC_ERROR(error));
-			}
+// receives every converted event, the index is the index of the event in the result
+typedef void (*CompactEventSink)(void* sink_data, size_t index, AssCompactEvent event);
 
-			char* result_buffer = NULL;
-			FORMAT_STRING_DEFAULT(&result_buffer, "%s, assuming UTF-8 (ascii also works with that)",
-			                      error);
+[[nodiscard]] static ErrorStruct convert_to_compact_events(AssParseResult* result,
+                                                           CompactEventSink sink,
+                                                           void* sink_data) {
 
-			WarningEntry warning = { .type = WarningTypeSimple,
-				                     .data = { .simple = result_buffer } };
+	Codepoints source = result->allocated_codepoints;
+	AssEvents* events = &(result->data.ok.events);
 
-			stbds_arrput(result->warnings.entries, warning); // NOLINT(clang-analyzer-unix.Malloc)
-			bom_size = 0;
-			codepoints_result = get_codepoints_from_utf8(data);
-			break;
-		}
-		case FileTypeUtf8: {
-			bom_size = 1;
-			codepoints_result = get_codepoints_from_utf8(data);
-			break;
-		}
-		case FileTypeUtf16BE: {
-			bom_size = 1;
-			codepoints_result = get_codepoints_from_utf16(data, true);
-			break;
-		}
-		case FileTypeUtf16LE: {
-			bom_size = 1;
-			codepoints_result = get_codepoints_from_utf16(data, false);
-			break;
-		}
-		case FileTypeUtf32BE: {
-			bom_size = 1;
-			codepoints_result = get_codepoints_from_utf32(data, true);
-			break;
-		}
-		case FileTypeUtf32LE: {
-			bom_size = 1;
-			codepoints_result = get_codepoints_from_utf32(data, false);
-			break;
-		}
+	// decoding may add warnings to the result
+	ThreadAllocation previous_allocation = use_result_allocation(result);
 
-		default: {
-			free_sized_ptr(data);
+	for(size_t i = 0; i < stbds_arrlenu(events->entries); ++i) {
+		AssEventEntry* entry = &(events->entries[i]);
 
-			char* result_buffer = NULL;
-			FORMAT_STRING_DEFAULT(&result_buffer,
-			                      "only UTF-8 encoded files supported atm, but got: %s",
-			                      get_file_type_name(file_type));
+		ErrorStruct error = decode_event_fields(events, entry, AssEventFieldAll);
 
-			RETURN_ERROR(DYNAMIC_ERROR(result_buffer));
+		AssCompactEvent compact_event = {};
+
+		if(error.message == NULL) {
+			error = get_compact_event(*entry, source, &compact_event);
 		}
+
+		if(error.message != NULL) {
+			set_thread_allocation(previous_allocation);
+			return error;
+		}
+
+		sink(sink_data, i, compact_event);
 	}
 
-	free_sized_ptr(data);
+	set_thread_allocation(previous_allocation);
 
-	if(codepoints_result.has_error) {
-		RETURN_ERROR(STATIC_ERROR(codepoints_result.data.error));
+	return NO_ERROR();
+}
+
+[[nodiscard]] static ErrorStruct check_compact_source(AssParseResult* result) {
+
+	if(result->is_error) {
+		return STATIC_ERROR("the result is an error");
 	}
 
-	Codepoints final_data = codepoints_result.data.result;
+	if(result->allocated_codepoints.size > UINT32_MAX) {
+		return STATIC_ERROR("the source is too big for the compact layout");
+	}
 
-	if(final_data.data == NULL && final_data.size == 0) {
-		RETURN_ERROR(STATIC_ERROR("file conversion resulted in empty UTF-8 string"));
+	return NO_ERROR();
+}
+
+static void store_compact_event(void* sink_data, size_t index, AssCompactEvent event) {
+	((AssCompactEvent*)sink_data)[index] = event;
+}
+
+[[nodiscard]] ErrorStruct parse_result_get_compact_events(AssParseResult* result,
+                                                          AssCompactEvents* compact_events) {
+
+	ErrorStruct error = check_compact_source(result);
+
+	if(error.message != NULL) {
+		return error;
 	}
 
-	result->allocated_codepoints = final_data;
+	// the compact events are not owned by the result, so they can't be in its arena
+	ThreadAllocation previous_allocation = set_thread_allocation(
+	    (ThreadAllocation){ .allocator = result->settings.allocator, .arena = NULL });
 
-	StrView data_view = str_view_from_data(final_data);
+	STBDS_ARRAY(AssCompactEvent) entries = STBDS_ARRAY_EMPTY;
+	stbds_arrsetlen(entries, stbds_arrlenu(result->data.ok.events.entries));
 
-	if(bom_size > 0) {
-		// NOTE: the bom byte is always just one codepoint
-		if(!str_view_advance(&data_view, bom_size)) {
-			RETURN_ERROR(STATIC_ERROR("couldn't skip bom bytes"));
-		}
+	set_thread_allocation(previous_allocation);
+
+	error = convert_to_compact_events(result, store_compact_event, entries);
+
+	if(error.message != NULL) {
+		stbds_arrfree(entries);
+		return error;
 	}
 
-	// get line type
-	char* line_type_error = NULL;
+	*compact_events =
+	    (AssCompactEvents){ .entries = entries, .source = result->allocated_codepoints.data };
 
-	ConstStrView line_type_view = get_const_str_view_from_str_view(data_view);
+	return NO_ERROR();
+}
 
-	LineType line_type = get_line_type(line_type_view, &line_type_error);
+[[nodiscard]] FinalStr compact_events_get_str(AssCompactEvents compact_events, AssCompactStr str) {
+	return (FinalStr){ .start = compact_events.source + str.offset, .length = str.length };
+}
 
-	if(line_type_error != NULL) {
-		RETURN_ERROR(DYNAMIC_ERROR(line_type_error));
+void free_compact_events(AssCompactEvents compact_events) {
+	stbds_arrfree(compact_events.entries);
+}
+
+#define EVENT_COLUMN_ALIGNMENT 16
+
+// reserves a column of count elements of the given size in the memory of the columns, without
+// memory, only the needed size is counted
+[[nodiscard]] static void* reserve_event_column(char* memory, size_t* used, size_t count,
+                                                size_t element_size) {
+
+	size_t offset = (*used + (EVENT_COLUMN_ALIGNMENT - 1)) & ~((size_t)EVENT_COLUMN_ALIGNMENT - 1);
+
+	*used = offset + (count * element_size);
+
+	return memory == NULL ? NULL : memory + offset;
+}
+
+// returns the size of the memory, that the columns need
+static size_t layout_event_columns(AssEventColumns* columns, char* memory, size_t count) {
+
+	size_t used = 0;
+
+	columns->count = count;
+	columns->start = reserve_event_column(memory, &used, count, sizeof(AssPackedTime));
+	columns->end = reserve_event_column(memory, &used, count, sizeof(AssPackedTime));
+	columns->layer = reserve_event_column(memory, &used, count, sizeof(uint32_t));
+	columns->style_index = reserve_event_column(memory, &used, count, sizeof(uint32_t));
+	columns->name = reserve_event_column(memory, &used, count, sizeof(AssCompactStr));
+	columns->effect = reserve_event_column(memory, &used, count, sizeof(AssCompactStr));
+	columns->text = reserve_event_column(memory, &used, count, sizeof(AssCompactStr));
+	columns->margin_l = reserve_event_column(memory, &used, count, sizeof(uint16_t));
+	columns->margin_r = reserve_event_column(memory, &used, count, sizeof(uint16_t));
+	columns->margin_v = reserve_event_column(memory, &used, count, sizeof(uint16_t));
+	columns->type = reserve_event_column(memory, &used, count, sizeof(EventType));
+	columns->flags = reserve_event_column(memory, &used, count, sizeof(uint8_t));
+	columns->memory = memory;
+
+	return used;
+}
+
+static void store_event_column_values(void* sink_data, size_t index, AssCompactEvent event) {
+
+	AssEventColumns* columns = (AssEventColumns*)sink_data;
+
+	columns->start[index] = event.start;
+	columns->end[index] = event.end;
+	columns->layer[index] = event.layer;
+	columns->style_index[index] = event.style_index;
+	columns->name[index] = event.name;
+	columns->effect[index] = event.effect;
+	columns->text[index] = event.text;
+	columns->margin_l[index] = event.margin_l;
+	columns->margin_r[index] = event.margin_r;
+	columns->margin_v[index] = event.margin_v;
+	columns->type[index] = event.type;
+	columns->flags[index] = event.flags;
+}
+
+[[nodiscard]] ErrorStruct parse_result_get_event_columns(AssParseResult* result,
+                                                         AssEventColumns* event_columns) {
+
+	ErrorStruct error = check_compact_source(result);
+
+	if(error.message != NULL) {
+		return error;
 	}
 
-	// parse script info
+	size_t event_count = stbds_arrlenu(result->data.ok.events.entries);
 
-	if(!str_view_expect_ascii(&data_view, "[Script Info]")) {
-		RETURN_ERROR(STATIC_ERROR("first line must be the script info section"));
+	AssEventColumns columns = {};
+	size_t memory_size = layout_event_columns(&columns, NULL, event_count);
+
+	// ass_malloc never allocates in the arena, the columns are not owned by the result
+	ThreadAllocation previous_allocation = use_result_allocation(result);
+	char* memory = (char*)ass_malloc(memory_size);
+	set_thread_allocation(previous_allocation);
+
+	if(!memory) {
+		return STATIC_ERROR("allocation error");
 	}
 
-	if(!str_view_expect_newline(&data_view, line_type)) {
-		RETURN_ERROR(STATIC_ERROR("expected newline"));
+	layout_event_columns(&columns, memory, event_count);
+	columns.source = result->allocated_codepoints.data;
+
+	error = convert_to_compact_events(result, store_event_column_values, &columns);
+
+	if(error.message != NULL) {
+		ass_free(memory);
+		return error;
 	}
 
-	AssResult ass_result = { .extra_sections = (ExtraSections){ .entries = STBDS_HASH_MAP_EMPTY },
-		                     .file_props = { .file_type = file_type, .line_type = line_type } };
+	*event_columns = columns;
 
-#undef FREE_AT_END
-#define FREE_AT_END() \
-	do { \
-		free_ass_result(ass_result); \
-	} while(false)
+	return NO_ERROR();
+}
 
-	ErrorStruct script_info_parse_result = parse_script_info(
-	    &(ass_result.script_info), &data_view, settings, line_type, &(result->warnings));
+void free_event_columns(AssEventColumns event_columns) {
+	ass_free(event_columns.memory);
+}
 
-	if(script_info_parse_result.message != NULL) {
-		RETURN_ERROR(script_info_parse_result);
+[[nodiscard]] static uint32_t get_compact_colour(AssColor colour) {
+	return ((uint32_t)colour.a << 24) | ((uint32_t)colour.b << 16) | ((uint32_t)colour.g << 8) |
+	       colour.r;
+}
+
+// uint16_t is enough for all size_t fields of a style, except the encoding, that is a single byte
+[[nodiscard]] static ErrorStruct get_compact_style(AssStyleEntry entry, Codepoints source,
+                                                   AssCompactStyle* compact_style) {
+
+	if(entry.fontsize > UINT16_MAX || entry.scale_x > UINT16_MAX || entry.scale_y > UINT16_MAX ||
+	   entry.margin_l > UINT16_MAX || entry.margin_r > UINT16_MAX || entry.margin_v > UINT16_MAX ||
+	   entry.encoding > UINT8_MAX) {
+		return STATIC_ERROR("style value doesn't fit into the compact style layout");
 	}
 
-	while(true) {
+	uint8_t flags = (entry.bold ? AssCompactStyleFlagBold : 0) |
+	                (entry.italic ? AssCompactStyleFlagItalic : 0) |
+	                (entry.underline ? AssCompactStyleFlagUnderline : 0) |
+	                (entry.strike_out ? AssCompactStyleFlagStrikeOut : 0);
+
+	*compact_style = (AssCompactStyle){
+		.name = get_compact_str(source, entry.name),
+		.fontname = get_compact_str(source, entry.fontname),
+		.primary_colour = get_compact_colour(entry.primary_colour),
+		.secondary_colour = get_compact_colour(entry.secondary_colour),
+		.outline_colour = get_compact_colour(entry.outline_colour),
+		.back_colour = get_compact_colour(entry.back_colour),
+		.spacing = (float)entry.spacing,
+		.angle = (float)entry.angle,
+		.outline = (float)entry.outline,
+		.shadow = (float)entry.shadow,
+		.fontsize = (uint16_t)entry.fontsize,
+		.scale_x = (uint16_t)entry.scale_x,
+		.scale_y = (uint16_t)entry.scale_y,
+		.margin_l = (uint16_t)entry.margin_l,
+		.margin_r = (uint16_t)entry.margin_r,
+		.margin_v = (uint16_t)entry.margin_v,
+		.encoding = (uint8_t)entry.encoding,
+		.border_style = entry.border_style,
+		.alignment = entry.alignment,
+		.flags = flags,
+	};
 
-		// classify section, and then parsing that section
+	return NO_ERROR();
+}
 
-		if(!str_view_expect_ascii(&data_view, "[")) {
-			RETURN_ERROR(STATIC_ERROR("implementation error"));
-		}
+[[nodiscard]] ErrorStruct parse_result_get_compact_styles(AssParseResult* result,
+                                                          AssCompactStyles* compact_styles) {
 
-		ConstStrView section_name = {};
-		if(!str_view_get_substring_by_char_delimiter(&data_view, &section_name, ']', false)) {
-			RETURN_ERROR(STATIC_ERROR("script section not terminated by ']'"));
-		}
+	ErrorStruct check_error = check_compact_source(result);
 
-		if(!str_view_expect_newline(&data_view, line_type)) {
-			RETURN_ERROR(STATIC_ERROR("no newline after section name"));
-		}
+	if(check_error.message != NULL) {
+		return check_error;
+	}
 
-		ErrorStruct section_parse_result = get_section_by_name(
-		    section_name, &ass_result, &data_view, settings, line_type, &(result->warnings));
+	Codepoints source = result->allocated_codepoints;
 
-		if(section_parse_result.message != NULL) {
-			RETURN_ERROR(section_parse_result);
-		}
+	const AssStyles* styles = &(result->data.ok.styles);
 
-		if(str_view_is_eof(data_view)) {
-			break;
+	size_t style_count = stbds_arrlenu(styles->entries);
+
+	// the compact styles are not owned by the result, so they can't be in its arena
+	ThreadAllocation previous_allocation = set_thread_allocation(
+	    (ThreadAllocation){ .allocator = result->settings.allocator, .arena = NULL });
+
+	STBDS_ARRAY(AssCompactStyle) entries = STBDS_ARRAY_EMPTY;
+	stbds_arrsetlen(entries, style_count);
+
+	for(size_t i = 0; i < style_count; ++i) {
+		ErrorStruct error = get_compact_style(styles->entries[i], source, &(entries[i]));
+
+		if(error.message != NULL) {
+			stbds_arrfree(entries);
+			set_thread_allocation(previous_allocation);
+			return error;
 		}
 	}
 
-	result->is_error = false;
-	result->data.ok = ass_result;
-	return result;
+	set_thread_allocation(previous_allocation);
+
+	*compact_styles = (AssCompactStyles){ .entries = entries, .source = source.data };
+
+	return NO_ERROR();
 }
 
-#undef FREE_AT_END
+[[nodiscard]] FinalStr compact_styles_get_str(AssCompactStyles compact_styles, AssCompactStr str) {
+	return (FinalStr){ .start = compact_styles.source + str.offset, .length = str.length };
+}
+
+void free_compact_styles(AssCompactStyles compact_styles) {
+	stbds_arrfree(compact_styles.entries);
+}
 
 [[nodiscard]] Warnings get_warnings_from_result(AssParseResult* result) {
 	return result->warnings;
 }
 
+[[nodiscard]] RecoveredErrors get_recovered_errors_from_result(AssParseResult* result) {
+	return result->recovered_errors;
+}
+
 [[nodiscard]] bool parse_result_is_error(AssParseResult* result) {
 	if(!result) {
 		return true;
@@ -1562,14 +5493,18 @@ static void free_ass_result(AssResult data) {
 }
 
 void free_parse_result(AssParseResult* result) {
-	if(!result->is_error) {
-		free_ass_result(result->data.ok);
-	} else {
+	if(result->is_error) {
 		free_error_struct(result->data.error);
 	}
 
-	free_warnings(result->warnings);
+	// everything else is owned by the arena, so only the error messages are freed one by one
+	for(size_t i = 0; i < stbds_arrlenu(result->recovered_errors.entries); ++i) {
+		free_error_struct(result->recovered_errors.entries[i].error);
+	}
+
 	free_codepoints(result->allocated_codepoints);
+	ass_free(result->raw_source.data.data);
+	free_arena(&(result->arena));
 
-	free(result);
+	allocator_free(result->settings.allocator, result);
 }
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "../helper/allocator.h"
 #include "../helper/sized_ptr.h"
 #include "../helper/string_view.h"
 #include "./warnings.h"
@@ -17,6 +18,7 @@ typedef struct {
 	AssSourceType type;
 	union {
 		const char* file;
+		// owned by the parser, it is freed with the allocator of the settings
 		SizedPtr str;
 	} data;
 } AssSource;
@@ -33,8 +35,86 @@ typedef struct {
 	bool allow_unrecognized_file_encoding;
 } StrictSettings;
 
+typedef struct {
+	uint8_t hour;
+	uint8_t min;
+	uint8_t sec;
+	uint8_t hundred;
+} AssTime;
+
+// an AssTime in hundredths of a second, packed times can be compared and subtracted directly
+typedef uint32_t AssPackedTime;
+
+[[nodiscard]] AssPackedTime get_packed_time(AssTime time);
+
+[[nodiscard]] AssTime get_unpacked_time(AssPackedTime time);
+
+typedef enum : uint8_t {
+	EventTypeDialogue,
+	EventTypeComment,
+	EventTypePicture,
+	EventTypeSound,
+	EventTypeMovie,
+	EventTypeCommand
+} EventType;
+
+// events, that don't match the filter, are skipped while parsing, the rest of their line is not
+// validated
+typedef struct {
+	// only keeps the events, that overlap [window_start, window_end)
+	bool has_time_window;
+	AssTime window_start;
+	AssTime window_end;
+	// the (1 << EventType) bits of the event types, that are skipped
+	uint8_t skipped_types;
+	// only keeps the events with a layer in [min_layer, max_layer]
+	bool has_layer_range;
+	size_t min_layer;
+	size_t max_layer;
+	// only keeps the events with one of these ascii style names, no styles keep all events, the
+	// array is not copied and has to outlive the parse result
+	STBDS_ARRAY(const char*) styles;
+} AssEventFilter;
+
+// sections, that can be skipped with ParseSettings.skipped_sections, skipped sections stay in the
+// section table and can be parsed later with parse_result_parse_section
+typedef enum : uint8_t {
+	AssSectionMaskStyles = 1 << 0,
+	AssSectionMaskEvents = 1 << 1,
+	AssSectionMaskFonts = 1 << 2,
+	AssSectionMaskGraphics = 1 << 3,
+	AssSectionMaskExtra = 1 << 4,
+} AssSectionMask;
+
 typedef struct {
 	StrictSettings strict_settings;
+	// maximum amount of threads used by a parse, including the calling one, they are used for the
+	// sections and the events section, 0 and 1 both mean, that no additional threads are started
+	size_t thread_count;
+	// event lines are only split into their fields, the number and time fields are decoded on
+	// first use with decode_event_fields
+	bool lazy_event_fields;
+	// the AssSectionMask bits of the sections, that are not parsed, the script info is always
+	// parsed
+	uint8_t skipped_sections;
+	// stops right after the script info section, for UTF-8 files only that part is decoded, the
+	// section table of the result only contains the script info section
+	bool script_info_only;
+	AssEventFilter event_filter;
+	// errors in the lines of the styles and events section and errors in whole later sections are
+	// collected in the result, the line or section is skipped and parsing goes on, errors in the
+	// script info section still end the parse
+	bool recover_from_errors;
+	// the error after that many collected ones ends the parse, 0 means no limit
+	size_t max_recovered_errors;
+	// adds a warning for every event, whose style is not in the styles section
+	bool warn_unknown_styles;
+	// the name, effect and text of every event get an id into AssEvents.strings, equal strings get
+	// the same id
+	bool intern_event_strings;
+	// all memory of the parse goes through this allocator, NULL means malloc, realloc and free, it
+	// is not copied and has to outlive the parse result and every error returned for it
+	const AssAllocator* allocator;
 } ParseSettings;
 
 typedef enum : uint8_t {
@@ -126,25 +206,58 @@ typedef struct {
 	size_t encoding;
 } AssStyleEntry;
 
+#define ASS_STYLE_INDEX_UNKNOWN UINT32_MAX
+
 typedef struct {
 	STBDS_ARRAY(AssStyleEntry) entries;
+	// open addressing hash table of the style names, a slot holds the index of the style plus one,
+	// 0 is an empty slot, it is built once the styles are parsed
+	STBDS_ARRAY(uint32_t) name_index;
 } AssStyles;
 
+// a range of codepoints in the source of a compact layout
+typedef struct {
+	uint32_t offset;
+	uint32_t length;
+} AssCompactStr;
+
 typedef enum : uint8_t {
-	EventTypeDialogue,
-	EventTypeComment,
-	EventTypePicture,
-	EventTypeSound,
-	EventTypeMovie,
-	EventTypeCommand
-} EventType;
+	AssCompactStyleFlagBold = 1 << 0,
+	AssCompactStyleFlagItalic = 1 << 1,
+	AssCompactStyleFlagUnderline = 1 << 2,
+	AssCompactStyleFlagStrikeOut = 1 << 3,
+} AssCompactStyleFlag;
+
+// the same as AssStyleEntry in one cache line (64 bytes) instead of 160 bytes, the colours are
+// packed like in the script (0xAABBGGRR)
+typedef struct {
+	AssCompactStr name;
+	AssCompactStr fontname;
+	uint32_t primary_colour;
+	uint32_t secondary_colour;
+	uint32_t outline_colour;
+	uint32_t back_colour;
+	float spacing;
+	float angle;
+	float outline;
+	float shadow;
+	uint16_t fontsize;
+	uint16_t scale_x;
+	uint16_t scale_y;
+	uint16_t margin_l;
+	uint16_t margin_r;
+	uint16_t margin_v;
+	uint8_t encoding;
+	BorderStyle border_style;
+	AssAlignment alignment;
+	uint8_t flags;
+} AssCompactStyle;
 
 typedef struct {
-	uint8_t hour;
-	uint8_t min;
-	uint8_t sec;
-	uint8_t hundred;
-} AssTime;
+	STBDS_ARRAY(AssCompactStyle) entries;
+	// the strings are offsets into this
+	int32_t* source;
+} AssCompactStyles;
 
 typedef struct {
 	bool is_default;
@@ -153,25 +266,117 @@ typedef struct {
 	} data;
 } MarginValue;
 
+// the event fields, that are decoded lazily, if lazy_event_fields is set
+typedef enum : uint8_t {
+	AssEventFieldLayer = 1 << 0,
+	AssEventFieldStart = 1 << 1,
+	AssEventFieldEnd = 1 << 2,
+	AssEventFieldMarginL = 1 << 3,
+	AssEventFieldMarginR = 1 << 4,
+	AssEventFieldMarginV = 1 << 5,
+	AssEventFieldAll = (1 << 6) - 1,
+} AssEventField;
+
+#define ASS_LAZY_EVENT_FIELD_COUNT 6
+
 typedef struct {
 	// marks different event_types
 	EventType type;
+	// the AssEventFields, that are not decoded yet
+	uint8_t pending_fields;
+	// length of all fields before the text field, these are split again on decoding
+	uint32_t fields_length;
 	// original fields
 	size_t layer;
 	AssTime start;
 	AssTime end;
 	FinalStr style;
+	// index into AssStyles.entries, ASS_STYLE_INDEX_UNKNOWN, if there is no style with that name
+	// or the styles are not parsed yet
+	uint32_t style_index;
 	FinalStr name;
 	MarginValue margin_l;
 	MarginValue margin_r;
 	MarginValue margin_v;
 	FinalStr effect;
 	FinalStr text;
+	// ids into AssEvents.strings, ASS_STRING_ID_NONE without ParseSettings.intern_event_strings
+	uint32_t name_id;
+	uint32_t effect_id;
+	uint32_t text_id;
 } AssEventEntry;
 
+#define ASS_STRING_ID_NONE UINT32_MAX
+
+// every distinct string once, the id of a string is its index, ids are given in the order of the
+// first use and can change, when the result is changed
+typedef struct {
+	STBDS_ARRAY(FinalStr) entries;
+	// open addressing hash table of the entries, a slot holds the id plus one, 0 is an empty slot
+	STBDS_ARRAY(uint32_t) index;
+} AssStringPool;
+
 typedef struct {
 	STBDS_ARRAY(AssEventEntry) entries;
+	// only filled with ParseSettings.intern_event_strings
+	AssStringPool strings;
+	size_t dialogue_count;
+	size_t comment_count;
+	// position of every lazily decoded field in the format line, in the order of the AssEventField
+	// bits, SIZE_MAX if the format doesn't contain the field
+	size_t lazy_field_positions[ASS_LAZY_EVENT_FIELD_COUNT];
 } AssEvents;
+typedef enum : uint8_t {
+	AssCompactEventFlagMarginLDefault = 1 << 0,
+	AssCompactEventFlagMarginRDefault = 1 << 1,
+	AssCompactEventFlagMarginVDefault = 1 << 2,
+} AssCompactEventFlag;
+
+// the same as AssEventEntry in 48 instead of 160 bytes, a default margin is 0 and has its
+// AssCompactEventFlag set
+typedef struct {
+	AssPackedTime start;
+	AssPackedTime end;
+	uint32_t layer;
+	// index into AssStyles.entries, ASS_STYLE_INDEX_UNKNOWN, if there is no style with that name
+	uint32_t style_index;
+	AssCompactStr name;
+	AssCompactStr effect;
+	AssCompactStr text;
+	uint16_t margin_l;
+	uint16_t margin_r;
+	uint16_t margin_v;
+	EventType type;
+	uint8_t flags;
+} AssCompactEvent;
+
+typedef struct {
+	STBDS_ARRAY(AssCompactEvent) entries;
+	// the strings are offsets into this
+	int32_t* source;
+} AssCompactEvents;
+
+// the compact events as parallel columns, so that scanning one field doesn't touch the others
+typedef struct {
+	size_t count;
+	AssPackedTime* start;
+	AssPackedTime* end;
+	uint32_t* layer;
+	uint32_t* style_index;
+	AssCompactStr* name;
+	AssCompactStr* effect;
+	AssCompactStr* text;
+	uint16_t* margin_l;
+	uint16_t* margin_r;
+	uint16_t* margin_v;
+	EventType* type;
+	uint8_t* flags;
+	// the strings are offsets into this
+	int32_t* source;
+	// all columns are in this single allocation, every column starts 16 byte aligned
+	void* memory;
+} AssEventColumns;
+
 /* typedef struct {
     int todo;
 } AssFonts;
@@ -215,12 +420,163 @@ typedef struct {
 	FileProps file_props;
 } AssResult;
 
+// the offsets are codepoint offsets into the decoded file, the header line itself is not part of
+// the range [start, end)
+typedef struct {
+	FinalStr name;
+	size_t header_start;
+	size_t start;
+	size_t end;
+	size_t line_count;
+	bool parsed;
+} AssSectionEntry;
+
+typedef struct {
+	STBDS_ARRAY(AssSectionEntry) entries;
+} AssSections;
+
 typedef struct AssParseResultImpl AssParseResult;
 
 [[nodiscard]] AssParseResult* parse_ass(AssSource source, ParseSettings settings);
 
+// keeps the file buffer and the encoding conversion state between parses, so that parsing a lot of
+// files doesn't set them up again every time, a context may only be used by one thread at a time,
+// the results don't depend on it and can outlive it
+typedef struct AssParserContextImpl AssParserContext;
+
+[[nodiscard]] AssParserContext* alloc_parser_context(const AssAllocator* allocator);
+
+void free_parser_context(AssParserContext* context);
+
+// the same as parse_ass, but reuses the buffers of the context
+[[nodiscard]] AssParseResult* parse_ass_with_context(AssParserContext* context, AssSource source,
+                                                     ParseSettings settings);
+
+// only parses the script info section and builds the section table, all other sections can be
+// parsed afterwards in any order with parse_result_parse_section
+[[nodiscard]] AssParseResult* parse_ass_section_table(AssSource source, ParseSettings settings);
+
+[[nodiscard]] AssSections parse_result_get_sections(AssParseResult* result);
+
+[[nodiscard]] ErrorStruct parse_result_parse_section(AssParseResult* result,
+                                                     const char* section_name);
+
+typedef struct {
+	size_t parsed_lines;
+	// the lines of all sections, that are parsed, without their headers
+	size_t total_lines;
+	size_t parsed_sections;
+	size_t section_count;
+} AssParseProgress;
+
+typedef void (*AssParseProgressCallback)(AssParseProgress progress, void* user_data);
+
+// the limits of one parse_ass_step call, a zero limit means no limit, the limits are checked after
+// every few hundred lines, so a step can take a bit longer
+typedef struct {
+	size_t max_lines;
+	uint64_t max_microseconds;
+	// called after every checked block of lines, on the thread, that runs the step
+	AssParseProgressCallback progress_callback;
+	void* user_data;
+} AssParseBudget;
+
+typedef enum : uint8_t {
+	AssParseStatusContinue,
+	AssParseStatusDone,
+	AssParseStatusCancelled,
+} AssParseStatus;
+
+typedef struct AssParseJobImpl AssParseJob;
+
+// decodes the source and parses the script info section, the other sections are parsed by
+// parse_ass_step, that always parses sequentially, regardless of ParseSettings.thread_count
+[[nodiscard]] AssParseJob* parse_ass_start(AssSource source, ParseSettings settings);
+
+[[nodiscard]] AssParseStatus parse_ass_step(AssParseJob* job, AssParseBudget budget);
+
+[[nodiscard]] AssParseProgress parse_ass_get_progress(AssParseJob* job);
+
+// can be called from any thread, the running or next step stops after the current block of lines
+void parse_ass_cancel(AssParseJob* job);
+
+// frees the job, the result of an unfinished or cancelled job is an error
+[[nodiscard]] AssParseResult* parse_ass_finish(AssParseJob* job);
+
+// replaces the bytes [start, end) of the source of a previous result, the offsets are relative to
+// the original source in its original encoding (including the BOM), the replacement has the same
+// encoding, but no BOM
+typedef struct {
+	size_t start;
+	size_t end;
+	SizedPtr replacement;
+} AssSourceEdit;
+
+typedef struct {
+	STBDS_ARRAY(AssSourceEdit) entries;
+} AssSourceEdits;
+
+// applies the edits (sorted and not overlapping) to the source of the previous result and only
+// parses the affected event lines and the other affected sections again, untouched entries are
+// kept and their views are moved to the new source, if a section header or the format line of the
+// events is edited, the whole source is parsed again
+// the previous result is consumed, warnings without a position are kept as they were, unless the
+// section, that reports them, is parsed again
+// if the edited source can't be decoded (e.g. an edit splits a character), the error result keeps
+// its bytes, the next edits are applied to them and the source is parsed again, once it can be
+// decoded, invalid edits keep the bytes unchanged, the same holds for a result of parse_ass, whose
+// source couldn't be decoded, other results without a source (compacted ones, script info only
+// ones and ones, whose source couldn't be read) can't be edited, parse the source again with
+// parse_ass instead
+[[nodiscard]] AssParseResult* parse_ass_incremental(AssParseResult* previous,
+                                                    AssSourceEdits edits);
+
+// copies the parts of the decoded source, that the result references, into a new buffer and frees
+// the old one, all views are moved to the new buffer, pending lazy fields are decoded first, with
+// interned strings, equal event strings are only kept once, a compacted result can't be edited
+// incrementally and its unparsed sections can't be parsed anymore
+[[nodiscard]] ErrorStruct parse_result_compact(AssParseResult* result);
+
+// decodes the requested AssEventFields of the entry, if they are still pending, the decoded values
+// are stored in the entry, so later calls are free, fields that fail to decode stay pending
+[[nodiscard]] ErrorStruct decode_event_fields(const AssEvents* events, AssEventEntry* entry,
+                                              uint8_t fields);
+
+// converts the events of the result into the compact layout, pending lazy fields are decoded first,
+// values, that don't fit into the compact layout, are an error, the strings point into the source
+// of the result, so they are only valid as long as the result is not changed or freed
+[[nodiscard]] ErrorStruct parse_result_get_compact_events(AssParseResult* result,
+                                                          AssCompactEvents* compact_events);
+
+[[nodiscard]] FinalStr compact_events_get_str(AssCompactEvents compact_events, AssCompactStr str);
+
+void free_compact_events(AssCompactEvents compact_events);
+
+// the same as parse_result_get_compact_events, but stores the events column by column
+[[nodiscard]] ErrorStruct parse_result_get_event_columns(AssParseResult* result,
+                                                         AssEventColumns* event_columns);
+
+void free_event_columns(AssEventColumns event_columns);
+
+// converts the styles of the result into the compact layout, the same rules as for
+// parse_result_get_compact_events apply
+[[nodiscard]] ErrorStruct parse_result_get_compact_styles(AssParseResult* result,
+                                                          AssCompactStyles* compact_styles);
+
+[[nodiscard]] FinalStr compact_styles_get_str(AssCompactStyles compact_styles, AssCompactStr str);
+
+void free_compact_styles(AssCompactStyles compact_styles);
+
+// returns NULL, if there is no style with that name, if the name is used more than once, the last
+// style with it is returned, like renderers do
+[[nodiscard]] const AssStyleEntry* ass_result_find_style(const AssResult* result, FinalStr name);
+
 [[nodiscard]] Warnings get_warnings_from_result(AssParseResult* result);
 
+// only contains entries with ParseSettings.recover_from_errors, the result can still be an error,
+// if the script info section is broken or there were too many errors
+[[nodiscard]] RecoveredErrors get_recovered_errors_from_result(AssParseResult* result);
+
 [[nodiscard]] bool parse_result_is_error(AssParseResult* result);
 
 [[nodiscard]] char* parse_result_get_error(AssParseResult* result);
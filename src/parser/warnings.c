@@ -8,7 +8,7 @@
 
 void free_error_struct(ErrorStruct error) {
 	if(error.dynamic) {
-		free(error.message);
+		ass_free(error.message);
 	}
 }
 
@@ -16,13 +16,17 @@ static void free_warning_entry(WarningEntry entry) {
 
 	switch(entry.type) {
 		case WarningTypeSimple: {
-			free(entry.data.simple);
+			ass_free(entry.data.simple);
 			break;
 		}
 		case WarningTypeUnexpectedField: {
 			break;
 		}
-		case WarningTypeDuplicateField: {
+		case WarningTypeDuplicateField:
+		case WarningTypeTruncatedNumber:
+		case WarningTypeMissingScriptType:
+		case WarningTypeUnrecognizedFileType:
+		case WarningTypeUnknownStyle: {
 			break;
 		}
 		default: {
@@ -41,6 +45,14 @@ void free_warnings(Warnings warnings) {
 	stbds_arrfree(warnings.entries);
 }
 
+void free_recovered_errors(RecoveredErrors errors) {
+
+	for(size_t i = 0; i < stbds_arrlenu(errors.entries); ++i) {
+		free_error_struct(errors.entries[i].error);
+	}
+	stbds_arrfree(errors.entries);
+}
+
 ErrorStruct get_warnings_message_from_entry(WarningEntry entry) {
 
 	switch(entry.type) {
@@ -51,7 +63,7 @@ ErrorStruct get_warnings_message_from_entry(WarningEntry entry) {
 
 			UnexpectedFieldWarning data = entry.data.unexpected_field;
 
-			char* field_name = get_normalized_string(data.field);
+			char* field_name = alloc_normalized_string(data.field);
 
 			if(!field_name) {
 				return STATIC_ERROR("<warning message allocation error>");
@@ -61,7 +73,7 @@ ErrorStruct get_warnings_message_from_entry(WarningEntry entry) {
 			FORMAT_STRING_DEFAULT(&result_buffer, "unexpected field '%s' in '%s' section",
 			                      field_name, data.section);
 
-			free(field_name);
+			ass_free(field_name);
 
 			return DYNAMIC_ERROR(result_buffer);
 		}
@@ -69,7 +81,7 @@ ErrorStruct get_warnings_message_from_entry(WarningEntry entry) {
 
 			DuplicateFieldWarning data = entry.data.duplicate_field;
 
-			char* field_name = get_normalized_string(data.field);
+			char* field_name = alloc_normalized_string(data.field);
 
 			if(!field_name) {
 				return STATIC_ERROR("<warning message allocation error>");
@@ -79,7 +91,50 @@ ErrorStruct get_warnings_message_from_entry(WarningEntry entry) {
 			FORMAT_STRING_DEFAULT(&result_buffer, "duplicate field '%s' in '%s' section",
 			                      field_name, data.section);
 
-			free(field_name);
+			ass_free(field_name);
+
+			return DYNAMIC_ERROR(result_buffer);
+		}
+		case WarningTypeTruncatedNumber: {
+
+			TruncatedNumberWarning data = entry.data.truncated_number;
+
+			char* value_name = alloc_normalized_string(data.value);
+
+			if(!value_name) {
+				return STATIC_ERROR("<warning message allocation error>");
+			}
+
+			char* result_buffer = NULL;
+			FORMAT_STRING_DEFAULT(&result_buffer, "error, not a valid decimal number: %s",
+			                      value_name);
+
+			ass_free(value_name);
+
+			return DYNAMIC_ERROR(result_buffer);
+		}
+		case WarningTypeMissingScriptType: {
+			return STATIC_ERROR("missing script type in script info section");
+		}
+		case WarningTypeUnrecognizedFileType: {
+			return STATIC_ERROR("unrecognized file type, no BOM present, assuming UTF-8 (ascii "
+			                    "also works with that)");
+		}
+		case WarningTypeUnknownStyle: {
+
+			UnknownStyleWarning data = entry.data.unknown_style;
+
+			char* style_name = alloc_normalized_string(data.style);
+
+			if(!style_name) {
+				return STATIC_ERROR("<warning message allocation error>");
+			}
+
+			char* result_buffer = NULL;
+			FORMAT_STRING_DEFAULT(&result_buffer, "event uses the unknown style '%s'",
+			                      style_name);
+
+			ass_free(style_name);
 
 			return DYNAMIC_ERROR(result_buffer);
 		}
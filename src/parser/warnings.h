@@ -25,10 +25,16 @@ typedef struct {
 
 void free_error_struct(ErrorStruct error);
 
+// the message of a warning is only built in get_warnings_message_from_entry, so that warnings,
+// that are never looked at, don't cost an allocation
 typedef enum : uint8_t {
 	WarningTypeSimple,
 	WarningTypeUnexpectedField,
 	WarningTypeDuplicateField,
+	WarningTypeTruncatedNumber,
+	WarningTypeMissingScriptType,
+	WarningTypeUnrecognizedFileType,
+	WarningTypeUnknownStyle,
 } WarningType;
 
 typedef struct {
@@ -41,12 +47,25 @@ typedef struct {
 	FinalStr field;
 } DuplicateFieldWarning;
 
+typedef struct {
+	FinalStr value;
+	// the number, that was parsed before the first invalid character
+	size_t truncated_value;
+} TruncatedNumberWarning;
+
+typedef struct {
+	// the style field of the event
+	FinalStr style;
+} UnknownStyleWarning;
+
 typedef struct {
 	WarningType type;
 	union {
 		char* simple;
 		UnexpectedFieldWarning unexpected_field;
 		DuplicateFieldWarning duplicate_field;
+		TruncatedNumberWarning truncated_number;
+		UnknownStyleWarning unknown_style;
 	} data;
 } WarningEntry;
 
@@ -56,4 +75,18 @@ typedef struct {
 
 void free_warnings(Warnings warnings);
 
+// an error, that was skipped over in the error recovery mode
+typedef struct {
+	const char* section;
+	// the line or section header, on which the error occurred
+	FinalStr location;
+	ErrorStruct error;
+} RecoveredError;
+
+typedef struct {
+	STBDS_ARRAY(RecoveredError) entries;
+} RecoveredErrors;
+
+void free_recovered_errors(RecoveredErrors errors);
+
 [[nodiscard]] ErrorStruct get_warnings_message_from_entry(WarningEntry entry);
@@ -8,6 +8,21 @@
 #ifndef _HAVE_STBDS_DECL
 #define _HAVE_STBDS_DECL
 
+#include <stddef.h>
+
+// stb_ds only includes this, if it uses the default allocator
+#include <stdlib.h>
+
+// arrays and hash maps are allocated like everything else, that a parse result owns, so that they
+// can be passed between the library and its users, the rest of the allocation functions is internal
+// (see helper/arena.h)
+[[nodiscard]] void* ass_arena_realloc(void* ptr, size_t size);
+
+void ass_free(void* ptr);
+
+#define STBDS_REALLOC(context, ptr, size) ass_arena_realloc(ptr, size)
+#define STBDS_FREE(context, ptr) ass_free(ptr)
+
 #define STBDS_NO_SHORT_NAMES
 #include "./stb_ds.h"
 
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <ass_parser_lib.h>
+#include <stb/ds.h>
+
+#include <stdio.h>
+#include <string.h>
+
+// compares two parse results field by field and prints the first difference, the tests use it to
+// check, that two ways of parsing the same source give the same result
+
+[[nodiscard]] static bool final_strs_equal(FinalStr first, FinalStr second) {
+
+	if(first.length != second.length) {
+		return false;
+	}
+
+	if(first.length == 0) {
+		return true;
+	}
+
+	return memcmp(first.start, second.start, first.length * sizeof(*first.start)) == 0;
+}
+
+[[nodiscard]] static bool report_difference(const char* context, const char* what, size_t index) {
+	fprintf(stderr, "%s: the %s at %zu differs\n", context, what, index);
+	return false;
+}
+
+#define COMPARE_FIELD(context, what, index, first, second, field) \
+	do { \
+		if((first).field != (second).field) { \
+			return report_difference(context, what "." #field, index); \
+		} \
+	} while(false)
+
+#define COMPARE_STR_FIELD(context, what, index, first, second, field) \
+	do { \
+		if(!final_strs_equal((first).field, (second).field)) { \
+			return report_difference(context, what "." #field, index); \
+		} \
+	} while(false)
+
+#define COMPARE_COLOR_FIELD(context, what, index, first, second, field) \
+	do { \
+		if(memcmp(&((first).field), &((second).field), sizeof(AssColor)) != 0) { \
+			return report_difference(context, what "." #field, index); \
+		} \
+	} while(false)
+
+[[nodiscard]] static bool script_infos_equal(AssScriptInfo first, AssScriptInfo second,
+                                             const char* context) {
+
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, title);
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, original_script);
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, original_translation);
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, original_editing);
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, original_timing);
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, synch_point);
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, script_updated_by);
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, update_details);
+	COMPARE_FIELD(context, "script info", 0, first, second, script_type);
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, collisions);
+	COMPARE_FIELD(context, "script info", 0, first, second, play_res_y);
+	COMPARE_FIELD(context, "script info", 0, first, second, play_res_x);
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, play_depth);
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, timer);
+	COMPARE_FIELD(context, "script info", 0, first, second, wrap_style);
+	COMPARE_FIELD(context, "script info", 0, first, second, scaled_border_and_shadow);
+	COMPARE_FIELD(context, "script info", 0, first, second, video_aspect_ratio);
+	COMPARE_FIELD(context, "script info", 0, first, second, video_zoom);
+	COMPARE_STR_FIELD(context, "script info", 0, first, second, ycbcr_matrix);
+
+	return true;
+}
+
+[[nodiscard]] static bool styles_equal(AssStyles first, AssStyles second, const char* context) {
+
+	if(stbds_arrlenu(first.entries) != stbds_arrlenu(second.entries)) {
+		return report_difference(context, "style count", 0);
+	}
+
+	for(size_t i = 0; i < stbds_arrlenu(first.entries); ++i) {
+		AssStyleEntry first_style = first.entries[i];
+		AssStyleEntry second_style = second.entries[i];
+
+		COMPARE_STR_FIELD(context, "style", i, first_style, second_style, name);
+		COMPARE_STR_FIELD(context, "style", i, first_style, second_style, fontname);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, fontsize);
+		COMPARE_COLOR_FIELD(context, "style", i, first_style, second_style, primary_colour);
+		COMPARE_COLOR_FIELD(context, "style", i, first_style, second_style, secondary_colour);
+		COMPARE_COLOR_FIELD(context, "style", i, first_style, second_style, outline_colour);
+		COMPARE_COLOR_FIELD(context, "style", i, first_style, second_style, back_colour);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, bold);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, italic);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, underline);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, strike_out);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, scale_x);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, scale_y);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, spacing);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, angle);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, border_style);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, outline);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, shadow);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, alignment);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, margin_l);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, margin_r);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, margin_v);
+		COMPARE_FIELD(context, "style", i, first_style, second_style, encoding);
+	}
+
+	return true;
+}
+
+[[nodiscard]] static bool margins_equal(MarginValue first, MarginValue second) {
+
+	if(first.is_default != second.is_default) {
+		return false;
+	}
+
+	return first.is_default || first.data.value == second.data.value;
+}
+
+// the string ids are not compared, as they can change, when a result is changed
+[[nodiscard]] static bool events_equal(AssEvents first, AssEvents second, const char* context) {
+
+	if(stbds_arrlenu(first.entries) != stbds_arrlenu(second.entries)) {
+		return report_difference(context, "event count", 0);
+	}
+
+	COMPARE_FIELD(context, "events", 0, first, second, dialogue_count);
+	COMPARE_FIELD(context, "events", 0, first, second, comment_count);
+
+	for(size_t i = 0; i < stbds_arrlenu(first.entries); ++i) {
+		AssEventEntry first_event = first.entries[i];
+		AssEventEntry second_event = second.entries[i];
+
+		COMPARE_FIELD(context, "event", i, first_event, second_event, type);
+		COMPARE_FIELD(context, "event", i, first_event, second_event, pending_fields);
+		COMPARE_FIELD(context, "event", i, first_event, second_event, layer);
+		COMPARE_FIELD(context, "event", i, first_event, second_event, start.hour);
+		COMPARE_FIELD(context, "event", i, first_event, second_event, start.min);
+		COMPARE_FIELD(context, "event", i, first_event, second_event, start.sec);
+		COMPARE_FIELD(context, "event", i, first_event, second_event, start.hundred);
+		COMPARE_FIELD(context, "event", i, first_event, second_event, end.hour);
+		COMPARE_FIELD(context, "event", i, first_event, second_event, end.min);
+		COMPARE_FIELD(context, "event", i, first_event, second_event, end.sec);
+		COMPARE_FIELD(context, "event", i, first_event, second_event, end.hundred);
+		COMPARE_STR_FIELD(context, "event", i, first_event, second_event, style);
+		COMPARE_FIELD(context, "event", i, first_event, second_event, style_index);
+		COMPARE_STR_FIELD(context, "event", i, first_event, second_event, name);
+		COMPARE_STR_FIELD(context, "event", i, first_event, second_event, effect);
+		COMPARE_STR_FIELD(context, "event", i, first_event, second_event, text);
+
+		if(!margins_equal(first_event.margin_l, second_event.margin_l) ||
+		   !margins_equal(first_event.margin_r, second_event.margin_r) ||
+		   !margins_equal(first_event.margin_v, second_event.margin_v)) {
+			return report_difference(context, "event margin", i);
+		}
+	}
+
+	return true;
+}
+
+[[nodiscard]] static bool extra_sections_equal(ExtraSections first, ExtraSections second,
+                                               const char* context) {
+
+	if(stbds_shlenu(first.entries) != stbds_shlenu(second.entries)) {
+		return report_difference(context, "extra section count", 0);
+	}
+
+	for(size_t i = 0; i < stbds_shlenu(first.entries); ++i) {
+		ExtraSectionHashMapEntry first_section = first.entries[i];
+		ptrdiff_t index = stbds_shgeti(second.entries, first_section.key);
+
+		if(index < 0) {
+			return report_difference(context, "extra section name", i);
+		}
+
+		STBDS_HASH_MAP(SectionFieldEntry) first_fields = first_section.value.fields;
+		STBDS_HASH_MAP(SectionFieldEntry) second_fields = second.entries[index].value.fields;
+
+		if(stbds_shlenu(first_fields) != stbds_shlenu(second_fields)) {
+			return report_difference(context, "extra section field count", i);
+		}
+
+		for(size_t j = 0; j < stbds_shlenu(first_fields); ++j) {
+			ptrdiff_t field_index = stbds_shgeti(second_fields, first_fields[j].key);
+
+			if(field_index < 0 ||
+			   !final_strs_equal(first_fields[j].value, second_fields[field_index].value)) {
+				return report_difference(context, "extra section field", i);
+			}
+		}
+	}
+
+	return true;
+}
+
+[[nodiscard]] static bool warnings_equal(Warnings first, Warnings second, const char* context) {
+
+	if(stbds_arrlenu(first.entries) != stbds_arrlenu(second.entries)) {
+		return report_difference(context, "warning count", 0);
+	}
+
+	for(size_t i = 0; i < stbds_arrlenu(first.entries); ++i) {
+		ErrorStruct first_message = get_warnings_message_from_entry(first.entries[i]);
+		ErrorStruct second_message = get_warnings_message_from_entry(second.entries[i]);
+
+		bool are_equal = first_message.message != NULL && second_message.message != NULL &&
+		                 strcmp(first_message.message, second_message.message) == 0;
+
+		free_error_struct(first_message);
+		free_error_struct(second_message);
+
+		if(!are_equal) {
+			return report_difference(context, "warning", i);
+		}
+	}
+
+	return true;
+}
+
+[[nodiscard]] static bool recovered_errors_equal(RecoveredErrors first, RecoveredErrors second,
+                                                 const char* context) {
+
+	if(stbds_arrlenu(first.entries) != stbds_arrlenu(second.entries)) {
+		return report_difference(context, "recovered error count", 0);
+	}
+
+	for(size_t i = 0; i < stbds_arrlenu(first.entries); ++i) {
+		RecoveredError first_error = first.entries[i];
+		RecoveredError second_error = second.entries[i];
+
+		if(strcmp(first_error.section, second_error.section) != 0 ||
+		   strcmp(first_error.error.message, second_error.error.message) != 0) {
+			return report_difference(context, "recovered error", i);
+		}
+
+		COMPARE_STR_FIELD(context, "recovered error", i, first_error, second_error, location);
+	}
+
+	return true;
+}
+
+[[nodiscard]] static bool sections_equal(AssSections first, AssSections second,
+                                         const char* context) {
+
+	if(stbds_arrlenu(first.entries) != stbds_arrlenu(second.entries)) {
+		return report_difference(context, "section count", 0);
+	}
+
+	for(size_t i = 0; i < stbds_arrlenu(first.entries); ++i) {
+		AssSectionEntry first_section = first.entries[i];
+		AssSectionEntry second_section = second.entries[i];
+
+		COMPARE_STR_FIELD(context, "section", i, first_section, second_section, name);
+		COMPARE_FIELD(context, "section", i, first_section, second_section, header_start);
+		COMPARE_FIELD(context, "section", i, first_section, second_section, start);
+		COMPARE_FIELD(context, "section", i, first_section, second_section, end);
+		COMPARE_FIELD(context, "section", i, first_section, second_section, line_count);
+		COMPARE_FIELD(context, "section", i, first_section, second_section, parsed);
+	}
+
+	return true;
+}
+
+// the file type is not compared, so that differently encoded sources can be compared
+[[nodiscard]] static bool parse_results_equal(AssParseResult* first, AssParseResult* second,
+                                              const char* context) {
+
+	if(parse_result_is_error(first) || parse_result_is_error(second)) {
+		if(parse_result_is_error(first) != parse_result_is_error(second)) {
+			fprintf(stderr, "%s: only one result is an error: %s\n", context,
+			        parse_result_get_error(parse_result_is_error(first) ? first : second));
+			return false;
+		}
+
+		if(strcmp(parse_result_get_error(first), parse_result_get_error(second)) != 0) {
+			fprintf(stderr, "%s: the errors differ: '%s' and '%s'\n", context,
+			        parse_result_get_error(first), parse_result_get_error(second));
+			return false;
+		}
+
+		return true;
+	}
+
+	AssResult first_value = parse_result_get_value(first);
+	AssResult second_value = parse_result_get_value(second);
+
+	if(first_value.file_props.line_type != second_value.file_props.line_type) {
+		return report_difference(context, "line type", 0);
+	}
+
+	return script_infos_equal(first_value.script_info, second_value.script_info, context) &&
+	       styles_equal(first_value.styles, second_value.styles, context) &&
+	       events_equal(first_value.events, second_value.events, context) &&
+	       extra_sections_equal(first_value.extra_sections, second_value.extra_sections,
+	                            context) &&
+	       warnings_equal(get_warnings_from_result(first), get_warnings_from_result(second),
+	                      context) &&
+	       recovered_errors_equal(get_recovered_errors_from_result(first),
+	                              get_recovered_errors_from_result(second), context) &&
+	       sections_equal(parse_result_get_sections(first), parse_result_get_sections(second),
+	                      context);
+}
@@ -0,0 +1,45 @@
+#include <ass_parser_lib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// an empty file is read as an empty source, that the parser rejects with a message, instead of an
+// allocation error without one
+
+int main(int argc, const char* argv[]) {
+
+	if(argc != 2) {
+		fprintf(stderr, "usage: %s <empty file>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const char* file = argv[1];
+
+	SizedPtr source = read_entire_file(file);
+
+	if(is_ptr_error(source) || source.len != 0) {
+		fprintf(stderr, "'%s' wasn't read as an empty source\n", file);
+		return EXIT_FAILURE;
+	}
+
+	free_sized_ptr(source);
+
+	AssParseResult* result = parse_ass(
+	    (AssSource){ .type = AssSourceTypeFile, .data = { .file = file } }, (ParseSettings){});
+
+	if(!result) {
+		fprintf(stderr, "couldn't allocate the result\n");
+		return EXIT_FAILURE;
+	}
+
+	bool success = parse_result_is_error(result) && parse_result_get_error(result) != NULL &&
+	               parse_result_get_error(result)[0] != '\0';
+
+	if(!success) {
+		fprintf(stderr, "'%s' didn't give an error with a message\n", file);
+	}
+
+	free_parse_result(result);
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
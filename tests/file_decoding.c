@@ -0,0 +1,55 @@
+#include "./compare_results.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// a file in another encoding has to give the same result as the UTF-8 file with the same content
+
+[[nodiscard]] static AssParseResult* parse_file(const char* file) {
+
+	ParseSettings settings = { .warn_unknown_styles = true };
+
+	return parse_ass((AssSource){ .type = AssSourceTypeFile, .data = { .file = file } }, settings);
+}
+
+int main(int argc, const char* argv[]) {
+
+	if(argc != 4) {
+		fprintf(stderr, "usage: %s <utf-8 file> <file> <file type of the file>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const char* file_type_name = argv[3];
+
+	AssParseResult* expected = parse_file(argv[1]);
+	AssParseResult* actual = parse_file(argv[2]);
+
+	if(!expected || !actual) {
+		fprintf(stderr, "couldn't allocate the results\n");
+		return EXIT_FAILURE;
+	}
+
+	bool success = parse_results_equal(expected, actual, argv[2]);
+
+	if(parse_result_is_error(expected)) {
+		fprintf(stderr, "%s: %s\n", argv[1], parse_result_get_error(expected));
+		success = false;
+	}
+
+	if(success) {
+		const char* actual_name =
+		    get_file_type_name(parse_result_get_value(actual).file_props.file_type);
+
+		if(strcmp(actual_name, file_type_name) != 0) {
+			fprintf(stderr, "%s: the file type is %s instead of %s\n", argv[2], actual_name,
+			        file_type_name);
+			success = false;
+		}
+	}
+
+	free_parse_result(expected);
+	free_parse_result(actual);
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
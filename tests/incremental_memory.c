@@ -0,0 +1,202 @@
+#include <ass_parser_lib.h>
+#include <stb/ds.h>
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// repeated incremental parses of the same edits have to reuse the memory of the previous ones, so
+// that an editor, that parses after every keystroke, doesn't grow without bounds
+
+#define WARM_UP_EDITS 200
+#define CHECKED_EDITS 20000
+
+// the size of every allocation is stored in front of it
+#define SIZE_PREFIX alignof(max_align_t)
+
+typedef struct {
+	size_t live_bytes;
+} CountingAllocator;
+
+static void* counting_malloc(void* user_data, size_t size) {
+	CountingAllocator* counter = (CountingAllocator*)user_data;
+
+	char* memory = (char*)malloc(SIZE_PREFIX + size);
+
+	if(!memory) {
+		return NULL;
+	}
+
+	*(size_t*)memory = size;
+	counter->live_bytes += size;
+
+	return memory + SIZE_PREFIX;
+}
+
+static void counting_free(void* user_data, void* ptr) {
+	CountingAllocator* counter = (CountingAllocator*)user_data;
+
+	if(ptr == NULL) {
+		return;
+	}
+
+	char* memory = (char*)ptr - SIZE_PREFIX;
+
+	counter->live_bytes -= *(size_t*)memory;
+	free(memory);
+}
+
+static void* counting_realloc(void* user_data, void* ptr, size_t size) {
+	CountingAllocator* counter = (CountingAllocator*)user_data;
+
+	if(ptr == NULL) {
+		return counting_malloc(user_data, size);
+	}
+
+	char* memory = (char*)ptr - SIZE_PREFIX;
+	size_t previous_size = *(size_t*)memory;
+
+	char* new_memory = (char*)realloc(memory, SIZE_PREFIX + size);
+
+	if(!new_memory) {
+		return NULL;
+	}
+
+	*(size_t*)new_memory = size;
+	counter->live_bytes = counter->live_bytes - previous_size + size;
+
+	return new_memory + SIZE_PREFIX;
+}
+
+// inserts an 'x' at the offset on even edits and removes it again on odd ones
+[[nodiscard]] static AssParseResult* apply_toggle_edit(AssParseResult* result, size_t offset,
+                                                       size_t edit_index) {
+
+	char replacement = 'x';
+	bool is_insertion = edit_index % 2 == 0;
+
+	AssSourceEdit edit = {
+		.start = offset,
+		.end = is_insertion ? offset : offset + 1,
+		.replacement = { .data = is_insertion ? &replacement : NULL,
+		                 .len = is_insertion ? 1 : 0 },
+	};
+
+	AssSourceEdits edits = { .entries = STBDS_ARRAY_EMPTY };
+	stbds_arrput(edits.entries, edit);
+
+	AssParseResult* new_result = parse_ass_incremental(result, edits);
+
+	stbds_arrfree(edits.entries);
+
+	return new_result;
+}
+
+// returns the offset after the first occurrence of the marker or 0, if it isn't found
+[[nodiscard]] static size_t find_offset_after(SizedPtr source, const char* marker) {
+
+	size_t marker_length = strlen(marker);
+
+	for(size_t i = 0; i + marker_length <= source.len; ++i) {
+		if(memcmp((const char*)source.data + i, marker, marker_length) == 0) {
+			return i + marker_length;
+		}
+	}
+
+	return 0;
+}
+
+[[nodiscard]] static bool check_edits_at(const char* file, SizedPtr source, const char* marker,
+                                         ParseSettings settings, CountingAllocator* counter) {
+
+	size_t offset = find_offset_after(source, marker);
+
+	if(offset == 0) {
+		fprintf(stderr, "marker '%s' not found in '%s'\n", marker, file);
+		return false;
+	}
+
+	AssParseResult* result =
+	    parse_ass((AssSource){ .type = AssSourceTypeFile, .data = { .file = file } }, settings);
+
+	size_t warmed_up_bytes = 0;
+
+	for(size_t i = 0; i < WARM_UP_EDITS + CHECKED_EDITS; ++i) {
+		if(parse_result_is_error(result)) {
+			fprintf(stderr, "edit %zu after '%s' failed: %s\n", i, marker,
+			        parse_result_get_error(result));
+			free_parse_result(result);
+			return false;
+		}
+
+		if(i == WARM_UP_EDITS) {
+			warmed_up_bytes = counter->live_bytes;
+		}
+
+		result = apply_toggle_edit(result, offset, i);
+	}
+
+	size_t final_bytes = counter->live_bytes;
+
+	free_parse_result(result);
+
+	if(final_bytes > warmed_up_bytes) {
+		fprintf(stderr,
+		        "memory grew from %zu to %zu bytes over %d edits after '%s' (interned: %s)\n",
+		        warmed_up_bytes, final_bytes, CHECKED_EDITS, marker,
+		        settings.intern_event_strings ? "yes" : "no");
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, const char* argv[]) {
+
+	if(argc != 2) {
+		fprintf(stderr, "usage: %s <file>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const char* file = argv[1];
+
+	SizedPtr source = read_entire_file(file);
+
+	if(source.data == NULL) {
+		fprintf(stderr, "couldn't read '%s'\n", file);
+		return EXIT_FAILURE;
+	}
+
+	CountingAllocator counter = { .live_bytes = 0 };
+
+	AssAllocator allocator = { .malloc_fn = counting_malloc,
+		                       .realloc_fn = counting_realloc,
+		                       .free_fn = counting_free,
+		                       .user_data = &counter };
+
+	ParseSettings settings = { .allocator = &allocator, .warn_unknown_styles = true };
+
+	// an event line, a style line and a script info line
+	const char* markers[] = { "Hello 1", "\nStyle: Default", "Title: Default" };
+
+	bool success = true;
+
+	for(size_t i = 0; i < sizeof(markers) / sizeof(*markers); ++i) {
+		for(size_t interned = 0; interned < 2; ++interned) {
+			settings.intern_event_strings = interned != 0;
+			success = check_edits_at(file, source, markers[i], settings, &counter) && success;
+		}
+	}
+
+	free_sized_ptr(source);
+
+	if(counter.live_bytes != 0) {
+		fprintf(stderr, "%zu bytes are still allocated after every result was freed\n",
+		        counter.live_bytes);
+		success = false;
+	}
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
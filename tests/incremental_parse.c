@@ -0,0 +1,490 @@
+#include "./compare_results.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// every edit is applied with parse_ass_incremental and to a copy of the bytes of the source, the
+// incremental result has to be the same as the result of parsing that copy again with parse_ass,
+// every scenario runs with LF and with CRLF line endings, with and without interned strings
+
+#define MAX_STEP_EDITS 4
+
+// removes everything after the start of the edit
+#define REMOVE_REST SIZE_MAX
+
+// the edit starts right after the first occurrence of the marker in the current source, removes
+// that many bytes or everything up to and including the first occurrence of removed_until and
+// inserts the replacement there, every "\n" in these strings becomes "\r\n" with CRLF
+typedef struct {
+	const char* marker;
+	size_t removed;
+	const char* removed_until;
+	const char* replacement;
+} EditSpec;
+
+typedef struct {
+	// the edits of one parse_ass_incremental call, in source order, a NULL marker ends them
+	EditSpec edits[MAX_STEP_EDITS];
+	// the edits are invalid, the source has to stay as it was
+	bool is_invalid;
+} EditStep;
+
+typedef struct {
+	const char* name;
+	const char* source;
+	const EditStep* steps;
+	size_t step_count;
+} EditScenario;
+
+#define SCENARIO(scenario_name, scenario_source, scenario_steps) \
+	{ .name = (scenario_name), \
+	  .source = (scenario_source), \
+	  .steps = (scenario_steps), \
+	  .step_count = sizeof(scenario_steps) / sizeof(*(scenario_steps)) }
+
+#define BOM "\xEF\xBB\xBF"
+
+#define SCRIPT_INFO "[Script Info]\nTitle: Edits\nScriptType: v4.00+\nPlayResX: 640\n\n"
+
+#define STYLES \
+	"[V4+ Styles]\n" \
+	"Format: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, " \
+	"BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, " \
+	"BorderStyle, Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding\n" \
+	"Style: Default,Arial,20,&H00FFFFFF,&H000000FF,&H00000000,&H00000000,0,0,0,0,100,100,0,0," \
+	"1,2,2,2,10,10,10,1\n" \
+	"Style: Sign,Arial,30,&H00FFFFFF,&H000000FF,&H00000000,&H00000000,-1,0,0,0,100,100,0,0," \
+	"1,2,2,8,10,10,10,1\n\n"
+
+#define EVENTS \
+	"[Events]\n" \
+	"Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\n" \
+	"Dialogue: 0,0:00:01.00,0:00:02.00,Default,,0,0,0,,Hello 1\n" \
+	"Dialogue: 0,0:00:02.00,0:00:03.00,Default,,0,0,0,,Caf\xC3\xA9 2\n" \
+	"Comment: 0,0:00:03.00,0:00:04.00,Sign,,0,0,0,,Note 3\n"
+
+#define SOURCE BOM SCRIPT_INFO STYLES EVENTS
+
+// edits, that leave bytes behind, that can't be decoded, are errors until the bytes are fixed
+static const EditStep g_recovery_steps[] = {
+	// the first byte of a two byte character
+	{ .edits = { { .marker = "Hello 1", .removed = 0, .replacement = "\xC3" } } },
+	// its second byte
+	{ .edits = { { .marker = "Hello 1\xC3", .removed = 0, .replacement = "\xA9" } } },
+	// replaces only the second byte of a character
+	{ .edits = { { .marker = "Caf\xC3", .removed = 1, .replacement = "\xA8" } } },
+	// removes only the first byte of a character
+	{ .edits = { { .marker = "Caf", .removed = 1, .replacement = "" } } },
+	{ .edits = { { .marker = "Caf", .removed = 0, .replacement = "\xC3" } } },
+	// an invalid edit keeps the source as it was
+	{ .edits = { { .marker = "Note 3", .removed = 1000, .replacement = "" } },
+	  .is_invalid = true },
+	{ .edits = { { .marker = "Note", .removed = 0, .replacement = "d" } } },
+};
+
+// an empty source is an error, but text can still be inserted into it
+static const EditStep g_empty_source_steps[] = {
+	{ .edits = { { .marker = "", .removed = REMOVE_REST, .replacement = "" } } },
+	{ .edits = { { .marker = "", .removed = 0, .replacement = SOURCE } } },
+	{ .edits = { { .marker = "Hello", .removed = 0, .replacement = " again" } } },
+};
+
+static const EditStep g_event_text_steps[] = {
+	{ .edits = { { .marker = "Hello", .removed = 0, .replacement = " there" } } },
+	{ .edits = { { .marker = ",,Caf", .removed = 0, .replacement = "{\\i1}" } } },
+	{ .edits = { { .marker = "Note", .removed = 2, .replacement = "" } } },
+	// the name and the effect field
+	{ .edits = { { .marker = "0:00:02.00,Default,", .removed = 0, .replacement = "Speaker" },
+	             { .marker = "Sign,,0,0,0,", .removed = 0, .replacement = "Banner;20" } } },
+	// a comma in the text isn't a field separator
+	{ .edits = { { .marker = "there", .removed = 0, .replacement = ", and, more" } } },
+	// moves a field separator
+	{ .edits = { { .marker = "Speaker,0,0,0", .removed = 1, .replacement = "" } } },
+	{ .edits = { { .marker = "Speaker,0,0", .removed = 0, .replacement = "," } } },
+};
+
+static const EditStep g_event_field_steps[] = {
+	// the layer
+	{ .edits = { { .marker = "Dialogue: ", .removed = 1, .replacement = "5" } } },
+	{ .edits = { { .marker = "Comment: ", .removed = 1, .replacement = "12" } } },
+	// the times and the margins
+	{ .edits = { { .marker = "Dialogue: 5,0:00:0", .removed = 1, .replacement = "7" },
+	             { .marker = "Default,,", .removed = 1, .replacement = "15" } } },
+	// an invalid time is an error of the result
+	{ .edits = { { .marker = "Dialogue: 5,0:00:", .removed = 1, .replacement = "x" } } },
+	{ .edits = { { .marker = "Dialogue: 5,0:00:", .removed = 1, .replacement = "0" } } },
+	// the style of an event
+	{ .edits = { { .marker = "0:00:03.00,", .removed = 7, .replacement = "Sign" } } },
+	{ .edits = { { .marker = "0:00:03.00,", .removed = 4, .replacement = "Unknown" } } },
+	// the type of an event
+	{ .edits = { { .marker = "\xA9 2\n", .removed = 0, .replacement = "x" } } },
+	{ .edits = { { .marker = "\xA9 2\n", .removed = 1, .replacement = "" } } },
+};
+
+static const EditStep g_event_line_steps[] = {
+	// inserts a line
+	{ .edits = { { .marker = "Hello 1\n",
+	               .removed = 0,
+	               .replacement = "Dialogue: 1,0:00:05.00,0:00:06.00,Sign,,0,0,0,,Inserted\n" } } },
+	// deletes a line
+	{ .edits = { { .marker = "Hello 1\n", .removed_until = "\n", .replacement = "" } } },
+	// the last line without a line ending
+	{ .edits = { { .marker = "Note 3", .removed = REMOVE_REST, .replacement = "" } } },
+	{ .edits = { { .marker = "Note 3",
+	               .removed = 0,
+	               .replacement = "\nDialogue: 0,0:00:07.00,0:00:08.00,Default,,0,0,0,,Last" } } },
+	// empty lines between the events
+	{ .edits = { { .marker = "Hello 1\n", .removed = 0, .replacement = "\n\n" } } },
+	// deletes all events
+	{ .edits = { { .marker = "MarginV, Effect, Text\n",
+	               .removed = REMOVE_REST,
+	               .replacement = "" } } },
+	{ .edits = { { .marker = "MarginV, Effect, Text\n",
+	               .removed = 0,
+	               .replacement = "Dialogue: 0,0:00:01.00,0:00:02.00,Default,,0,0,0,,Back\n" } } },
+};
+
+static const EditStep g_style_steps[] = {
+	// the font size
+	{ .edits = { { .marker = "Style: Sign,Arial,", .removed = 2, .replacement = "42" } } },
+	// renames the style, that the comment uses
+	{ .edits = { { .marker = "Style: Sign", .removed = 0, .replacement = "Post" } } },
+	{ .edits = { { .marker = "Style: Sign", .removed = 4, .replacement = "" } } },
+	// an invalid colour is an error of the result
+	{ .edits = { { .marker = "Style: Default,Arial,20,&H", .removed = 1, .replacement = "x" } } },
+	{ .edits = { { .marker = "Style: Default,Arial,20,&H", .removed = 1, .replacement = "0" } } },
+	// inserts and deletes a style
+	{ .edits = { { .marker = "10,10,10,1\n",
+	               .removed = 0,
+	               .replacement = "Style: Extra,Arial,10,&H00FFFFFF,&H000000FF,&H00000000,"
+	                              "&H00000000,0,0,0,0,100,100,0,0,1,2,2,2,10,10,10,1\n" } } },
+	{ .edits = { { .marker = "10,10,10,1\n", .removed_until = "\n", .replacement = "" } } },
+	// the format line of the styles
+	{ .edits = { { .marker = "MarginR, MarginV", .removed = 10, .replacement = "" } } },
+	{ .edits = { { .marker = "MarginR, MarginV", .removed = 0, .replacement = ", Encoding" } } },
+};
+
+static const EditStep g_script_info_steps[] = {
+	{ .edits = { { .marker = "Title: ", .removed_until = "\n", .replacement = "Renamed\n" } } },
+	{ .edits = { { .marker = "PlayResX: ", .removed = 3, .replacement = "1280" } } },
+	// a new field and an unknown one
+	{ .edits = { { .marker = "PlayResX: 1280\n",
+	               .removed = 0,
+	               .replacement = "PlayResY: 720\nWrapStyle: 2\nUnknown: field\n" } } },
+	// the script type is missing afterwards
+	{ .edits = { { .marker = "Title: Renamed\n", .removed_until = "\n", .replacement = "" } } },
+	{ .edits = { { .marker = "Title: Renamed\n",
+	               .removed = 0,
+	               .replacement = "ScriptType: v4.00+\n" } } },
+	// the script info and the events at once
+	{ .edits = { { .marker = "Title: ", .removed = 7, .replacement = "Both" },
+	             { .marker = "Hello", .removed = 2, .replacement = "" } } },
+};
+
+static const EditStep g_section_steps[] = {
+	// the header of a section
+	{ .edits = { { .marker = "[V4+ ", .removed = 6, .replacement = "Stylez" } } },
+	{ .edits = { { .marker = "[V4+ ", .removed = 6, .replacement = "Styles" } } },
+	// an extra section
+	{ .edits = { { .marker = "PlayResX: 640\n\n",
+	               .removed = 0,
+	               .replacement = "[Aegisub Project Garbage]\nVideo File: video.mkv\n\n" } } },
+	{ .edits = { { .marker = "Video File: ", .removed = 5, .replacement = "audio" } } },
+	// the format line of the events
+	{ .edits = { { .marker = "Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, ",
+	               .removed = 8,
+	               .replacement = "" } } },
+	// the events don't have an effect field now
+	{ .edits = { { .marker = "Default,,0,0,0,", .removed = 1, .replacement = "" },
+	             { .marker = "Caf", .removed = 0, .replacement = "e" } } },
+};
+
+static const EditScenario g_scenarios[] = {
+	SCENARIO("event text", SOURCE, g_event_text_steps),
+	SCENARIO("event fields", SOURCE, g_event_field_steps),
+	SCENARIO("event lines", SOURCE, g_event_line_steps),
+	SCENARIO("styles", SOURCE, g_style_steps),
+	SCENARIO("script info", SOURCE, g_script_info_steps),
+	SCENARIO("sections", SOURCE, g_section_steps),
+	SCENARIO("recovery", SOURCE, g_recovery_steps),
+	SCENARIO("empty source", SOURCE, g_empty_source_steps),
+};
+
+// returns a copy of the text, where every "\n" is "\r\n", if the line endings are CRLF
+[[nodiscard]] static char* with_line_endings(const char* text, bool use_crlf) {
+
+	size_t length = strlen(text);
+	size_t line_count = 0;
+
+	for(size_t i = 0; use_crlf && i < length; ++i) {
+		line_count += text[i] == '\n' ? 1 : 0;
+	}
+
+	char* result = (char*)malloc(length + line_count + 1);
+
+	if(!result) {
+		return NULL;
+	}
+
+	size_t write_offset = 0;
+
+	for(size_t i = 0; i < length; ++i) {
+		if(use_crlf && text[i] == '\n') {
+			result[write_offset++] = '\r';
+		}
+
+		result[write_offset++] = text[i];
+	}
+
+	result[write_offset] = '\0';
+
+	return result;
+}
+
+// returns SIZE_MAX, if the marker isn't found after the offset
+[[nodiscard]] static size_t find_marker(SizedPtr source, size_t offset, const char* marker) {
+
+	size_t marker_length = strlen(marker);
+
+	for(size_t i = offset; i + marker_length <= source.len; ++i) {
+		if(memcmp((const char*)source.data + i, marker, marker_length) == 0) {
+			return i + marker_length;
+		}
+	}
+
+	return SIZE_MAX;
+}
+
+// the parser owns the data of a string source, so every parse gets a copy
+[[nodiscard]] static AssParseResult* parse_bytes(SizedPtr source, ParseSettings settings) {
+
+	// an empty source has no data, like an empty file
+	SizedPtr data = { .data = NULL, .len = 0 };
+
+	if(source.len > 0) {
+		data.data = malloc(source.len);
+
+		if(!data.data) {
+			return NULL;
+		}
+
+		memcpy(data.data, source.data, source.len);
+		data.len = source.len;
+	}
+
+	return parse_ass((AssSource){ .type = AssSourceTypeStr, .data = { .str = data } }, settings);
+}
+
+// the data of an empty source may be NULL, which memcpy doesn't allow
+static void copy_bytes(char* destination, const void* source, size_t size) {
+	if(size > 0) {
+		memcpy(destination, source, size);
+	}
+}
+
+// applies the edits to the bytes, that are replaced by the edited ones
+[[nodiscard]] static bool apply_edits(SizedPtr* source, AssSourceEdits edits) {
+
+	size_t new_length = source->len;
+
+	for(size_t i = 0; i < stbds_arrlenu(edits.entries); ++i) {
+		new_length = new_length - (edits.entries[i].end - edits.entries[i].start) +
+		             edits.entries[i].replacement.len;
+	}
+
+	char* buffer = (char*)malloc(new_length > 0 ? new_length : 1);
+
+	if(!buffer) {
+		return false;
+	}
+
+	size_t read_offset = 0;
+	size_t write_offset = 0;
+
+	for(size_t i = 0; i < stbds_arrlenu(edits.entries); ++i) {
+		AssSourceEdit edit = edits.entries[i];
+
+		copy_bytes(buffer + write_offset, (char*)source->data + read_offset,
+		           edit.start - read_offset);
+		write_offset += edit.start - read_offset;
+
+		copy_bytes(buffer + write_offset, edit.replacement.data, edit.replacement.len);
+		write_offset += edit.replacement.len;
+
+		read_offset = edit.end;
+	}
+
+	copy_bytes(buffer + write_offset, (char*)source->data + read_offset,
+	           source->len - read_offset);
+
+	free(source->data);
+	*source = (SizedPtr){ .data = buffer, .len = new_length };
+
+	return true;
+}
+
+// the replacements of the edits are owned by them
+static void free_step_edits(AssSourceEdits* edits) {
+
+	for(size_t i = 0; i < stbds_arrlenu(edits->entries); ++i) {
+		free(edits->entries[i].replacement.data);
+	}
+
+	stbds_arrfree(edits->entries);
+}
+
+// returns SIZE_MAX, if the end of the edit isn't found
+[[nodiscard]] static size_t get_edit_end(SizedPtr source, size_t start, EditSpec spec,
+                                         bool use_crlf) {
+
+	if(spec.removed_until == NULL) {
+		return spec.removed == REMOVE_REST ? source.len : start + spec.removed;
+	}
+
+	char* removed_until = with_line_endings(spec.removed_until, use_crlf);
+
+	if(!removed_until) {
+		return SIZE_MAX;
+	}
+
+	size_t end = find_marker(source, start, removed_until);
+
+	free(removed_until);
+
+	return end;
+}
+
+[[nodiscard]] static bool get_step_edits(SizedPtr source, const EditStep* step, bool use_crlf,
+                                         AssSourceEdits* edits, const char* context) {
+
+	for(size_t i = 0; i < MAX_STEP_EDITS && step->edits[i].marker != NULL; ++i) {
+		EditSpec spec = step->edits[i];
+
+		char* marker = with_line_endings(spec.marker, use_crlf);
+
+		if(!marker) {
+			return false;
+		}
+
+		size_t start = find_marker(source, 0, marker);
+
+		free(marker);
+
+		size_t end = start == SIZE_MAX ? SIZE_MAX : get_edit_end(source, start, spec, use_crlf);
+
+		if(end == SIZE_MAX) {
+			fprintf(stderr, "%s: the edit after '%s' is not in the source\n", context,
+			        spec.marker);
+			return false;
+		}
+
+		char* replacement = with_line_endings(spec.replacement, use_crlf);
+
+		if(!replacement) {
+			return false;
+		}
+
+		AssSourceEdit edit = {
+			.start = start,
+			.end = end,
+			.replacement = { .data = replacement, .len = strlen(replacement) },
+		};
+
+		stbds_arrput(edits->entries, edit);
+	}
+
+	return true;
+}
+
+[[nodiscard]] static bool run_scenario(EditScenario scenario, ParseSettings settings,
+                                       bool use_crlf) {
+
+	char* initial_source = with_line_endings(scenario.source, use_crlf);
+
+	if(!initial_source) {
+		return false;
+	}
+
+	SizedPtr source = { .data = initial_source, .len = strlen(initial_source) };
+
+	AssParseResult* result = parse_bytes(source, settings);
+
+	bool success = result != NULL;
+
+	for(size_t i = 0; i < scenario.step_count && success; ++i) {
+		const EditStep* step = &(scenario.steps[i]);
+
+		char context[256];
+		snprintf(context, sizeof(context), "%s (%s, interned: %s), step %zu", scenario.name,
+		         use_crlf ? "CRLF" : "LF", settings.intern_event_strings ? "yes" : "no", i);
+
+		AssSourceEdits edits = { .entries = STBDS_ARRAY_EMPTY };
+
+		if(!get_step_edits(source, step, use_crlf, &edits, context)) {
+			free_step_edits(&edits);
+			success = false;
+			break;
+		}
+
+		result = parse_ass_incremental(result, edits);
+
+		if(!result) {
+			free_step_edits(&edits);
+			success = false;
+			break;
+		}
+
+		if(step->is_invalid) {
+			if(!parse_result_is_error(result)) {
+				fprintf(stderr, "%s: the invalid edits were accepted\n", context);
+				success = false;
+			}
+
+			free_step_edits(&edits);
+			continue;
+		}
+
+		success = apply_edits(&source, edits);
+		free_step_edits(&edits);
+
+		AssParseResult* expected = success ? parse_bytes(source, settings) : NULL;
+
+		if(!expected) {
+			success = false;
+			break;
+		}
+
+		success = parse_results_equal(expected, result, context);
+
+		free_parse_result(expected);
+	}
+
+	if(result != NULL) {
+		free_parse_result(result);
+	}
+
+	free(source.data);
+
+	return success;
+}
+
+int main(void) {
+
+	// an empty source has no BOM, so its file type can't be recognized
+	ParseSettings settings = { .strict_settings = { .allow_unrecognized_file_encoding = true },
+		                       .warn_unknown_styles = true };
+
+	bool success = true;
+
+	for(size_t i = 0; i < sizeof(g_scenarios) / sizeof(*g_scenarios); ++i) {
+		for(size_t crlf = 0; crlf < 2; ++crlf) {
+			for(size_t interned = 0; interned < 2; ++interned) {
+				settings.intern_event_strings = interned != 0;
+				success = run_scenario(g_scenarios[i], settings, crlf != 0) && success;
+			}
+		}
+	}
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,189 @@
+#include "./compare_results.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// a parse with one thread and a parse with many threads have to give the same result, the
+// generated source has enough event lines, that the events section is split into a chunk per
+// thread, and enough sections, that they are parsed at the same time
+
+#define MANY_THREADS 8
+// more than MANY_THREADS chunks of the minimal size, that is parsed on its own thread
+#define EVENT_LINE_COUNT 40000
+
+// every n-th event is a comment, uses an unknown style or is broken
+#define COMMENT_INTERVAL 7
+#define UNKNOWN_STYLE_INTERVAL 97
+#define BROKEN_LINE_INTERVAL 1009
+
+typedef struct {
+	char* data;
+	size_t length;
+	size_t capacity;
+} SourceBuffer;
+
+[[nodiscard]] static bool append_format(SourceBuffer* buffer, const char* format, ...) {
+
+	va_list args;
+
+	va_start(args, format);
+	int needed = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+
+	if(needed < 0) {
+		return false;
+	}
+
+	size_t required = buffer->length + (size_t)needed + 1;
+
+	if(required > buffer->capacity) {
+		size_t new_capacity = buffer->capacity == 0 ? 4096 : buffer->capacity;
+
+		while(new_capacity < required) {
+			new_capacity *= 2;
+		}
+
+		char* new_data = (char*)realloc(buffer->data, new_capacity);
+
+		if(!new_data) {
+			return false;
+		}
+
+		buffer->data = new_data;
+		buffer->capacity = new_capacity;
+	}
+
+	va_start(args, format);
+	vsnprintf(buffer->data + buffer->length, buffer->capacity - buffer->length, format, args);
+	va_end(args);
+
+	buffer->length += (size_t)needed;
+
+	return true;
+}
+
+[[nodiscard]] static bool append_event(SourceBuffer* buffer, size_t index, bool with_errors) {
+
+	if(with_errors && index % BROKEN_LINE_INTERVAL == 0) {
+		return append_format(buffer, "Dialogue: 0,broken,0:00:01.00,Default,,0,0,0,,Broken %zu\n",
+		                     index);
+	}
+
+	const char* type = index % COMMENT_INTERVAL == 0 ? "Comment" : "Dialogue";
+	const char* style = index % UNKNOWN_STYLE_INTERVAL == 0 ? "Unknown"
+	                    : index % 2 == 0                    ? "Default"
+	                                                        : "Sign";
+
+	size_t seconds = index % 3600;
+
+	return append_format(buffer,
+	                     "%s: %zu,%zu:%02zu:%02zu.00,%zu:%02zu:%02zu.50,%s,Speaker %zu,0,0,0,,"
+	                     "Line %zu, with a comma and caf\xC3\xA9\n",
+	                     type, index % 5, seconds / 3600, (seconds / 60) % 60, seconds % 60,
+	                     seconds / 3600, (seconds / 60) % 60, seconds % 60, style, index % 13,
+	                     index);
+}
+
+[[nodiscard]] static bool generate_source(SourceBuffer* buffer, bool with_errors) {
+
+	bool success =
+	    append_format(buffer, "\xEF\xBB\xBF[Script Info]\nTitle: Threads\nScriptType: v4.00+\n"
+	                          "PlayResX: 1920\nPlayResY: 1080\n\n") &&
+	    append_format(buffer, "[Aegisub Project Garbage]\nVideo File: video.mkv\n\n") &&
+	    append_format(buffer,
+	                  "[V4+ Styles]\n"
+	                  "Format: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, "
+	                  "OutlineColour, BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, "
+	                  "ScaleY, Spacing, Angle, BorderStyle, Outline, Shadow, Alignment, MarginL, "
+	                  "MarginR, MarginV, Encoding\n"
+	                  "Style: Default,Arial,20,&H00FFFFFF,&H000000FF,&H00000000,&H00000000,0,0,0,"
+	                  "0,100,100,0,0,1,2,2,2,10,10,10,1\n"
+	                  "Style: Sign,Arial,30,&H00FFFFFF,&H000000FF,&H00000000,&H00000000,-1,0,0,"
+	                  "0,100,100,0,0,1,2,2,8,10,10,10,1\n\n") &&
+	    append_format(buffer, "[Events]\nFormat: Layer, Start, End, Style, Name, MarginL, "
+	                          "MarginR, MarginV, Effect, Text\n");
+
+	for(size_t i = 0; i < EVENT_LINE_COUNT && success; ++i) {
+		success = append_event(buffer, i, with_errors);
+	}
+
+	return success && append_format(buffer, "\n[Aegisub Extradata]\nData: 1,key,value\n");
+}
+
+// the parser owns the data of a string source, so every parse gets a copy
+[[nodiscard]] static AssParseResult* parse_source(SourceBuffer buffer, ParseSettings settings) {
+
+	char* data = (char*)malloc(buffer.length);
+
+	if(!data) {
+		return NULL;
+	}
+
+	memcpy(data, buffer.data, buffer.length);
+
+	return parse_ass((AssSource){ .type = AssSourceTypeStr,
+	                              .data = { .str = { .data = data, .len = buffer.length } } },
+	                 settings);
+}
+
+[[nodiscard]] static bool check_thread_counts(SourceBuffer buffer, ParseSettings settings,
+                                              const char* context) {
+
+	settings.thread_count = 1;
+	AssParseResult* expected = parse_source(buffer, settings);
+
+	settings.thread_count = MANY_THREADS;
+	AssParseResult* actual = parse_source(buffer, settings);
+
+	bool success = expected != NULL && actual != NULL;
+
+	if(!success) {
+		fprintf(stderr, "%s: couldn't allocate the results\n", context);
+	} else if(parse_result_is_error(expected)) {
+		fprintf(stderr, "%s: %s\n", context, parse_result_get_error(expected));
+		success = false;
+	} else {
+		success = parse_results_equal(expected, actual, context);
+	}
+
+	if(expected != NULL) {
+		free_parse_result(expected);
+	}
+
+	if(actual != NULL) {
+		free_parse_result(actual);
+	}
+
+	return success;
+}
+
+int main(void) {
+
+	SourceBuffer valid_source = { .data = NULL, .length = 0, .capacity = 0 };
+	SourceBuffer broken_source = { .data = NULL, .length = 0, .capacity = 0 };
+
+	if(!generate_source(&valid_source, false) || !generate_source(&broken_source, true)) {
+		fprintf(stderr, "couldn't generate the sources\n");
+		free(valid_source.data);
+		free(broken_source.data);
+		return EXIT_FAILURE;
+	}
+
+	ParseSettings settings = { .warn_unknown_styles = true };
+
+	bool success = check_thread_counts(valid_source, settings, "plain");
+
+	settings.intern_event_strings = true;
+	success = check_thread_counts(valid_source, settings, "interned") && success;
+
+	settings.intern_event_strings = false;
+	settings.recover_from_errors = true;
+	success = check_thread_counts(broken_source, settings, "recovered errors") && success;
+
+	free(valid_source.data);
+	free(broken_source.data);
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}